@@ -0,0 +1,306 @@
+/**
+ * file: Benchmark.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "MappedPointSet.h"
+
+#include "Quadtree.h"
+#include "QuadtreeConstructor.h"
+
+#include "WSSD.h"
+#include "WspdConstructor.h"
+#include "WssdConstructor.h"
+
+#include "Filtration.h"
+#include "FiltrationConstructor.h"
+
+#include "Exporter.h"
+#include "PersistenceReducer.h"
+#include "Metrics.h"
+
+#include "Benchmark.h"
+#include "Instantiations.h"
+
+// Top level stages that get a column in the CSV file, in pipeline order. A run only has some
+// of them, e.g. the fused strategy has no separate wspd and wssd_2 stages.
+static const char* csvStages[] =
+{
+    "load_points",
+    "quadtree",
+    "compress",
+    "wspd",
+    "wssd_2",
+    "vertices",
+    "prepare_tuples",
+    "wspd_wssd_prepare_tuples",
+    "filtration",
+    "persistence",
+    "export"
+};
+static const int kNumCsvStages = sizeof(csvStages) / sizeof(csvStages[0]);
+
+
+/**
+ * Maps a data set of DataGen, which stores doubles, into memory and converts the points to T.
+ */
+template<typename T, int D>
+static bool LoadDataSet(const std::string& fileName, MappedPointSet<double,D>& mappedPoints,
+    std::vector<vec<T,D>>& convertedPoints, PointSpan<T,D>& retPoints)
+{
+    if(!mappedPoints.Open(fileName, false))
+    {
+        return false;
+    }
+
+    PointSpan<double,D> doublePoints = mappedPoints.GetPoints();
+    convertedPoints.resize(doublePoints.size());
+    for(std::size_t i=0; i<doublePoints.size(); ++i)
+    {
+        for(int d=0; d<D; ++d)
+        {
+            convertedPoints[i][d] = T(doublePoints[i][d]);
+        }
+    }
+    retPoints = PointSpan<T,D>(convertedPoints);
+    return true;
+}
+
+/**
+ * Same as above, doubles are used in place, so loading doesn't touch the points.
+ */
+template<int D>
+static bool LoadDataSet(const std::string& fileName, MappedPointSet<double,D>& mappedPoints,
+    std::vector<vec<double,D>>& /*convertedPoints*/, PointSpan<double,D>& retPoints)
+{
+    if(!mappedPoints.Open(fileName, false))
+    {
+        return false;
+    }
+
+    retPoints = mappedPoints.GetPoints();
+    return true;
+}
+
+std::string BenchmarkCase::GetFileName() const
+{
+    char filename[128];
+    sprintf_s(filename, "%s_%i_%i_%i.bin", names[distribution], dimension, numPoints, iteration);
+    return filename;
+}
+
+
+template<typename T, int D>
+Benchmark<T,D>::Benchmark(bool computePersistence, bool exportFiltration)
+: computePersistence(computePersistence)
+, exportFiltration(exportFiltration)
+{}
+
+template<typename T, int D>
+bool Benchmark<T,D>::Run(const BenchmarkCase& benchCase, Metrics& retMetrics) const
+{
+    // Same settings as main.cpp
+    const double eta = benchCase.eps / 5.0;
+    const double wspdEta = eta / 2.0;
+    const double maxAlpha = std::numeric_limits<double>::infinity();
+
+    const std::string fileName = benchCase.GetFileName();
+
+    retMetrics.clear();
+    retMetrics.SetParameter("file", fileName);
+    retMetrics.SetParameter("distribution", names[benchCase.distribution]);
+    retMetrics.SetParameter("dimension", D);
+    retMetrics.SetParameter("scalar", scalarTypeNames[PointScalarTypeOf<T>::value]);
+    retMetrics.SetParameter("points", benchCase.numPoints);
+    retMetrics.SetParameter("iteration", benchCase.iteration);
+    retMetrics.SetParameter("eps", benchCase.eps);
+    retMetrics.SetParameter("max_delta", benchCase.maxDelta);
+    retMetrics.SetParameter("strategy", strategyNames[benchCase.strategy]);
+
+    // The quadtree keeps pointers into the points, they stay mapped until the end
+    MappedPointSet<double,D> mappedPoints;
+    std::vector<vec<T,D>> convertedPoints;
+    PointSpan<T,D> points;
+
+    retMetrics.BeginStage("load_points");
+    bool pointsRead = LoadDataSet(fileName, mappedPoints, convertedPoints, points);
+    retMetrics.AddCount("points", points.size());
+    retMetrics.EndStage();
+
+    if(!pointsRead || points.size() == 0)
+    {
+        return false;
+    }
+
+    QuadtreeConstructor<T,D> constructor;
+    retMetrics.BeginStage("quadtree");
+    Quadtree<T,D>* quadtree = constructor.ConstructQuadtree(points);
+    retMetrics.EndStage();
+
+    retMetrics.BeginStage("compress");
+    constructor.CompressQuadtree(quadtree);
+    retMetrics.EndStage();
+
+    Filtration<T,D> filtration;
+    FiltrationConstructor<T,D> filtrationConstructor(benchCase.eps, 0, benchCase.maxDelta);
+    filtrationConstructor.SetMetrics(&retMetrics);
+
+    WspdConstructor<T,D> wspdConstructor(wspdEta, maxAlpha);
+    WssdConstructor<T,D,2> wssd2Constructor(eta, maxAlpha);
+
+    if(benchCase.strategy == kFused)
+    {
+        filtrationConstructor.ConstructFiltration(quadtree, wspdConstructor, wssd2Constructor, filtration);
+    }
+    else
+    {
+        WSSD<T,D> wssd(eta);
+
+        retMetrics.BeginStage("wspd");
+        wspdConstructor.ConstructWspd(quadtree, wssd.GetKWssd<1>());
+        retMetrics.AddCount("pairs", wssd.GetKWssd<1>().size());
+        retMetrics.EndStage();
+
+        retMetrics.BeginStage("wssd_2");
+        wssd2Constructor.ConstructWssd(wssd.GetKWssd<1>(), quadtree, wssd.GetKWssd<2>());
+        retMetrics.AddCount("tuples", wssd.GetKWssd<2>().size());
+        retMetrics.EndStage();
+
+        filtrationConstructor.ConstructFiltration(wssd, filtration);
+    }
+
+    if(computePersistence)
+    {
+        retMetrics.BeginStage("persistence");
+        PersistenceReducer<T,D> persistenceReducer;
+        std::vector<PersistencePair> persistencePairs;
+        persistenceReducer.ComputePairs(filtration, persistencePairs);
+        retMetrics.AddCount("persistence_pairs", persistencePairs.size());
+        retMetrics.EndStage();
+    }
+
+    if(exportFiltration)
+    {
+        char outputFile[160];
+        sprintf_s(outputFile, "%s_%f.txt", fileName.c_str(), benchCase.eps);
+
+        retMetrics.BeginStage("export");
+        Exporter<T,D>().ExportFast(filtration, outputFile);
+        retMetrics.EndStage();
+
+        remove(outputFile);
+    }
+
+    delete quadtree;
+
+    return true;
+}
+
+
+bool BenchmarkReport::WriteCsvHeader(const std::string& filename)
+{
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file << "distribution,dimension,scalar,points,iteration,eps,max_delta,strategy";
+    for(int i=0; i<kNumCsvStages; ++i)
+    {
+        file << ',' << csvStages[i] << "_ms";
+    }
+    file << ",total_ms,total_cpu_ms,pairs,tuples_1,tuples_2,simplices,peak_rss_bytes,bytes_per_point" << std::endl;
+
+    return true;
+}
+
+bool BenchmarkReport::AppendCsv(const std::string& filename, const BenchmarkCase& benchCase, const Metrics& metrics)
+{
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::app);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    const std::vector<Metrics::Stage>& stages = metrics.GetStages();
+
+    char buffer[64];
+    file << names[benchCase.distribution] << ',' << benchCase.dimension << ',' << scalarTypeNames[benchCase.scalarType] << ','
+         << benchCase.numPoints << ','
+         << benchCase.iteration << ',' << benchCase.eps << ',' << benchCase.maxDelta << ',' << strategyNames[benchCase.strategy];
+
+    // Stages that don't occur in this run are left empty
+    for(int i=0; i<kNumCsvStages; ++i)
+    {
+        file << ',';
+        for(auto it = stages.cbegin(); it != stages.cend(); ++it)
+        {
+            if(it->depth == 0 && it->name == csvStages[i])
+            {
+                sprintf_s(buffer, "%.3f", it->wallMs);
+                file << buffer;
+                break;
+            }
+        }
+    }
+
+    double totalMs = 0.0;
+    double totalCpuMs = 0.0;
+    unsigned long long peakRssBytes = 0;
+    for(auto it = stages.cbegin(); it != stages.cend(); ++it)
+    {
+        if(it->depth == 0)
+        {
+            totalMs += it->wallMs;
+            totalCpuMs += it->cpuMs;
+        }
+        peakRssBytes = std::max(peakRssBytes, it->peakRssBytes);
+    }
+
+    sprintf_s(buffer, "%.3f", totalMs);
+    file << ',' << buffer;
+    sprintf_s(buffer, "%.3f", totalCpuMs);
+    file << ',' << buffer;
+
+    file << ',' << GetCount(metrics, "pairs")
+         << ',' << GetCount(metrics, "tuples_1")
+         << ',' << GetCount(metrics, "tuples_2")
+         << ',' << GetCount(metrics, "simplices")
+         << ',' << peakRssBytes;
+
+    sprintf_s(buffer, "%.1f", double(peakRssBytes) / std::max(1, benchCase.numPoints));
+    file << ',' << buffer << std::endl;
+
+    return true;
+}
+
+unsigned long long BenchmarkReport::GetCount(const Metrics& metrics, const std::string& name)
+{
+    unsigned long long value = 0;
+
+    const std::vector<Metrics::Stage>& stages = metrics.GetStages();
+    for(auto it = stages.cbegin(); it != stages.cend(); ++it)
+    {
+        for(auto count = it->counts.cbegin(); count != it->counts.cend(); ++count)
+        {
+            if(count->first == name)
+            {
+                value = count->second;
+            }
+        }
+    }
+
+    return value;
+}
+
+
+#define INSTANTIATE_BENCHMARK(T,D) template class Benchmark<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_BENCHMARK)
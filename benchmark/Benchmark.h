@@ -0,0 +1,109 @@
+/**
+ * file: Benchmark.h
+ * desc: End-to-end scaling benchmark. Runs the whole pipeline on a data set generated by
+ *       DataGen and records every stage with Metrics, so runs can be compared across n,
+ *       dimension, scalar type, epsilon, distribution and construction strategy.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <string>
+
+#include "DataGen.h"
+#include "PointFile.h"
+
+// Forward class declarations
+class Metrics;
+
+/**
+ * How the filtration is constructed: from a stored WSSD, or fused with the WSPD traversal.
+ */
+enum Strategy
+{
+    kStored = 0,
+    kFused,
+
+    kNumStrategies
+};
+
+static const char* strategyNames[kNumStrategies] =
+{
+    "stored",
+    "fused"
+};
+
+static const char* scalarTypeNames[] =
+{
+    "float",
+    "double"
+};
+
+/**
+ * A single run of the benchmark.
+ */
+struct BenchmarkCase
+{
+    Distribution    distribution;
+    int             dimension;
+    PointScalarType scalarType;     // Type the pipeline computes with, the data sets store doubles
+    int             numPoints;
+    int             iteration;      // Which of the data sets of DataGen with these parameters
+    double          eps;
+    int             maxDelta;
+    Strategy        strategy;
+
+    /**
+     * Name of the data set, as written by DataGen::GenerateDataSet.
+     */
+    std::string GetFileName() const;
+};
+
+template<typename T, int D>
+class Benchmark
+{
+// Fields
+private:
+    bool    computePersistence;
+    bool    exportFiltration;
+
+// Constructors
+public:
+    Benchmark(bool computePersistence, bool exportFiltration);
+
+// Functions
+public:
+    /**
+     * Runs the pipeline on the data set of 'benchCase' and records the stages in 'retMetrics'.
+     * Returns false if the data set could not be read.
+     */
+    bool Run(const BenchmarkCase& benchCase, Metrics& retMetrics) const;
+};
+
+/**
+ * Writes the results of the benchmark. Every run is one row of a CSV file with the wall time
+ * of the top level stages and the sizes of the intermediate results.
+ */
+class BenchmarkReport
+{
+public:
+    /**
+     * Creates the CSV file and writes the header. Returns if the operation was successful.
+     */
+    static bool WriteCsvHeader(const std::string& filename);
+
+    /**
+     * Appends the results of a run to the CSV file. Returns if the operation was successful.
+     */
+    static bool AppendCsv(const std::string& filename, const BenchmarkCase& benchCase, const Metrics& metrics);
+
+private:
+    /**
+     * Last value of the count 'name' in any stage, or 0 if no stage has it.
+     */
+    static unsigned long long GetCount(const Metrics& metrics, const std::string& name);
+};
+
+#endif //_BENCHMARK_H_
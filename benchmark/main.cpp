@@ -0,0 +1,493 @@
+/**
+ * file: main.cpp
+ * desc: Scaling benchmark. Sweeps the number of points, dimension, scalar type, distribution,
+ *       epsilon and construction strategy over the data sets of DataGen, generating the ones that are
+ *       missing in the working directory.
+ *
+ *       Every run is done in a child process (this executable with --run), so the peak memory
+ *       of a run isn't hidden by an earlier, larger one and runs don't share a heap. The
+ *       results are written to <out>.csv and <out>.json.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Metrics.h"
+#include "DataGen.h"
+#include "Benchmark.h"
+#include "Instantiations.h"
+
+/**
+ * Settings of the sweep, can be changed from the command line.
+ */
+struct BenchmarkSettings
+{
+    int                         minPoints;
+    int                         maxPoints;
+    std::vector<int>            dimensions;
+    std::vector<PointScalarType> scalarTypes;
+    std::vector<Distribution>   distributions;
+    std::vector<double>         eps;
+    std::vector<Strategy>       strategies;
+    int                         iterations;
+    int                         maxDelta;
+    bool                        computePersistence;
+    bool                        exportFiltration;
+    bool                        perfCounters;
+    std::string                 out;
+
+    BenchmarkSettings()
+    : minPoints(1<<7)
+    , maxPoints(1<<10)
+    , iterations(1)
+    , maxDelta(200)
+    , computePersistence(false)
+    , exportFiltration(false)
+    , perfCounters(false)
+    , out("benchmark")
+    {
+        dimensions.push_back(2);
+        scalarTypes.push_back(kScalarDouble);
+        distributions.push_back(kUniform);
+        distributions.push_back(kNormal);
+        eps.push_back(1.0);
+        eps.push_back(0.5);
+        strategies.push_back(kStored);
+        strategies.push_back(kFused);
+    }
+};
+
+static void PrintUsage()
+{
+    printf("Usage: benchmark [options]\n"
+           "  --min-n <n>           smallest number of points, doubled up to --max-n (default 128)\n"
+           "  --max-n <n>           largest number of points (default 1024)\n"
+           "  --dims <d,...>        dimensions, 2 to 8 (default 2)\n"
+           "  --scalar <s,...>      float, double (default double)\n"
+           "  --dists <name,...>    distributions: uniform, normal, testcase (default uniform,normal)\n"
+           "  --eps <eps,...>       values of epsilon (default 1,0.5)\n"
+           "  --strategy <s,...>    stored, fused (default stored,fused)\n"
+           "  --iterations <k>      data sets per configuration (default 1)\n"
+           "  --max-delta <delta>   last delta of the filtration (default 200)\n"
+           "  --persistence         also compute the persistence pairs\n"
+           "  --export              also export the filtration\n"
+           "  --perf                also record the hardware performance counters of every stage\n"
+           "  --out <prefix>        results are written to <prefix>.csv and <prefix>.json (default benchmark)\n");
+}
+
+/**
+ * Splits a comma separated list.
+ */
+static std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ','))
+    {
+        if(!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static bool ParseDistribution(const std::string& name, Distribution& retDistribution)
+{
+    for(int dist = 0; dist < kNumDistributions; ++dist)
+    {
+        if(name == names[dist])
+        {
+            retDistribution = Distribution(dist);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseScalarType(const std::string& name, PointScalarType& retScalarType)
+{
+    for(int scalarType = kScalarFloat; scalarType <= kScalarDouble; ++scalarType)
+    {
+        if(name == scalarTypeNames[scalarType])
+        {
+            retScalarType = PointScalarType(scalarType);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ParseStrategy(const std::string& name, Strategy& retStrategy)
+{
+    for(int strategy = 0; strategy < kNumStrategies; ++strategy)
+    {
+        if(name == strategyNames[strategy])
+        {
+            retStrategy = Strategy(strategy);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Parses the options shared by the sweep and the child runs. Returns false on an unknown option.
+ */
+static bool ParseSettings(int argc, char** argv, BenchmarkSettings& settings, std::vector<std::string>& retRunArgs)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i + 1 < argc);
+
+        if(arg == "--run" && i + 8 < argc)
+        {
+            retRunArgs.assign(argv + i + 1, argv + i + 9);
+            i += 8;
+        }
+        else if(arg == "--min-n" && hasValue)
+        {
+            settings.minPoints = atoi(argv[++i]);
+        }
+        else if(arg == "--max-n" && hasValue)
+        {
+            settings.maxPoints = atoi(argv[++i]);
+        }
+        else if(arg == "--dims" && hasValue)
+        {
+            std::vector<std::string> items = SplitList(argv[++i]);
+            settings.dimensions.clear();
+            for(auto it = items.cbegin(); it != items.cend(); ++it)
+            {
+                settings.dimensions.push_back(atoi(it->c_str()));
+            }
+        }
+        else if(arg == "--scalar" && hasValue)
+        {
+            std::vector<std::string> items = SplitList(argv[++i]);
+            settings.scalarTypes.clear();
+            for(auto it = items.cbegin(); it != items.cend(); ++it)
+            {
+                PointScalarType scalarType;
+                if(!ParseScalarType(*it, scalarType))
+                {
+                    printf("Unknown scalar type: %s\n", it->c_str());
+                    return false;
+                }
+                settings.scalarTypes.push_back(scalarType);
+            }
+        }
+        else if(arg == "--dists" && hasValue)
+        {
+            std::vector<std::string> items = SplitList(argv[++i]);
+            settings.distributions.clear();
+            for(auto it = items.cbegin(); it != items.cend(); ++it)
+            {
+                Distribution dist;
+                if(!ParseDistribution(*it, dist))
+                {
+                    printf("Unknown distribution: %s\n", it->c_str());
+                    return false;
+                }
+                settings.distributions.push_back(dist);
+            }
+        }
+        else if(arg == "--eps" && hasValue)
+        {
+            std::vector<std::string> items = SplitList(argv[++i]);
+            settings.eps.clear();
+            for(auto it = items.cbegin(); it != items.cend(); ++it)
+            {
+                settings.eps.push_back(atof(it->c_str()));
+            }
+        }
+        else if(arg == "--strategy" && hasValue)
+        {
+            std::vector<std::string> items = SplitList(argv[++i]);
+            settings.strategies.clear();
+            for(auto it = items.cbegin(); it != items.cend(); ++it)
+            {
+                Strategy strategy;
+                if(!ParseStrategy(*it, strategy))
+                {
+                    printf("Unknown strategy: %s\n", it->c_str());
+                    return false;
+                }
+                settings.strategies.push_back(strategy);
+            }
+        }
+        else if(arg == "--iterations" && hasValue)
+        {
+            settings.iterations = atoi(argv[++i]);
+        }
+        else if(arg == "--max-delta" && hasValue)
+        {
+            settings.maxDelta = atoi(argv[++i]);
+        }
+        else if(arg == "--persistence")
+        {
+            settings.computePersistence = true;
+        }
+        else if(arg == "--export")
+        {
+            settings.exportFiltration = true;
+        }
+        else if(arg == "--perf")
+        {
+            settings.perfCounters = true;
+        }
+        else if(arg == "--out" && hasValue)
+        {
+            settings.out = argv[++i];
+        }
+        else
+        {
+            printf("Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Name of the JSON file that the child run with the given index writes.
+ */
+static std::string GetRunJsonName(const BenchmarkSettings& settings, int index)
+{
+    std::ostringstream name;
+    name << settings.out << '_' << index << ".json";
+    return name.str();
+}
+
+/**
+ * Runs the benchmark of a case with the instantiation that DispatchInstantiation picks.
+ */
+struct BenchmarkRun
+{
+    const BenchmarkSettings&    settings;
+    const BenchmarkCase&        benchCase;
+    Metrics&                    metrics;
+    bool                        success;
+
+    BenchmarkRun(const BenchmarkSettings& settings, const BenchmarkCase& benchCase, Metrics& metrics)
+    : settings(settings)
+    , benchCase(benchCase)
+    , metrics(metrics)
+    , success(false)
+    {}
+
+    template<typename T, int D>
+    void Run()
+    {
+        success = Benchmark<T,D>(settings.computePersistence, settings.exportFiltration).Run(benchCase, metrics);
+    }
+};
+
+/**
+ * Runs a single case in this process and appends the results. The arguments are
+ * <index> <distribution> <dimension> <points> <iteration> <eps> <strategy> <scalar>.
+ */
+static int RunCase(const BenchmarkSettings& settings, const std::vector<std::string>& runArgs)
+{
+    const int index = atoi(runArgs[0].c_str());
+
+    BenchmarkCase benchCase;
+    benchCase.dimension = atoi(runArgs[2].c_str());
+    benchCase.numPoints = atoi(runArgs[3].c_str());
+    benchCase.iteration = atoi(runArgs[4].c_str());
+    benchCase.eps = atof(runArgs[5].c_str());
+    benchCase.maxDelta = settings.maxDelta;
+
+    if(!ParseDistribution(runArgs[1], benchCase.distribution) || !ParseStrategy(runArgs[6], benchCase.strategy) ||
+       !ParseScalarType(runArgs[7], benchCase.scalarType))
+    {
+        printf("Invalid run: %s %s %s\n", runArgs[1].c_str(), runArgs[6].c_str(), runArgs[7].c_str());
+        return -1;
+    }
+
+    Metrics metrics;
+
+    if(settings.perfCounters && !metrics.EnablePerfCounters())
+    {
+        printf("Hardware performance counters not available.\n");
+    }
+
+    // Only the instantiated dimensions can be run
+    BenchmarkRun run(settings, benchCase, metrics);
+    if(!DispatchInstantiation(benchCase.scalarType, benchCase.dimension, run))
+    {
+        printf("Dimension %d is not instantiated, only %d to %d are.\n", benchCase.dimension,
+            kMinInstantiatedDimension, kMaxInstantiatedDimension);
+        return -1;
+    }
+
+    if(!run.success)
+    {
+        printf("Couldn't read point set \"%s\"\n", benchCase.GetFileName().c_str());
+        return -1;
+    }
+
+    if(!BenchmarkReport::AppendCsv(settings.out + ".csv", benchCase, metrics) ||
+       !metrics.WriteJson(GetRunJsonName(settings, index)))
+    {
+        printf("Couldn't write the results to \"%s\"\n", settings.out.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Concatenates the JSON files of the child runs into a single array and removes them.
+ */
+static bool MergeRunJson(const BenchmarkSettings& settings, int numRuns)
+{
+    std::ofstream file((settings.out + ".json").c_str(), std::ios::out | std::ios::trunc);
+    if(!file.is_open())
+    {
+        return false;
+    }
+
+    file << "{\n\"runs\": [\n";
+    bool first = true;
+    for(int index = 0; index < numRuns; ++index)
+    {
+        const std::string runName = GetRunJsonName(settings, index);
+        std::ifstream run(runName.c_str());
+        if(!run.is_open())
+        {
+            // The run failed, it is missing from the CSV file as well
+            continue;
+        }
+
+        if(!first)
+        {
+            file << ",\n";
+        }
+        file << run.rdbuf();
+        first = false;
+
+        run.close();
+        remove(runName.c_str());
+    }
+    file << "]\n}\n";
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkSettings settings;
+    std::vector<std::string> runArgs;
+
+    if(!ParseSettings(argc, argv, settings, runArgs))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if(!runArgs.empty())
+    {
+        return RunCase(settings, runArgs);
+    }
+
+    if(!BenchmarkReport::WriteCsvHeader(settings.out + ".csv"))
+    {
+        printf("Couldn't create \"%s.csv\"\n", settings.out.c_str());
+        return -1;
+    }
+
+    // Options that are passed on to every run
+    std::ostringstream sharedArgs;
+    sharedArgs << " --max-delta " << settings.maxDelta << " --out " << settings.out;
+    if(settings.computePersistence)
+    {
+        sharedArgs << " --persistence";
+    }
+    if(settings.exportFiltration)
+    {
+        sharedArgs << " --export";
+    }
+    if(settings.perfCounters)
+    {
+        sharedArgs << " --perf";
+    }
+
+    DataGen<double> dataGen;
+    int numRuns = 0;
+    int numFailed = 0;
+
+    for(int n = settings.minPoints; n <= settings.maxPoints; n = n<<1)
+    {
+        for(auto dim = settings.dimensions.cbegin(); dim != settings.dimensions.cend(); ++dim)
+        {
+            for(auto dist = settings.distributions.cbegin(); dist != settings.distributions.cend(); ++dist)
+            {
+                // The test case is a pair of circles, it only exists in the plane
+                if(*dist == kSmallTestCase && *dim != 2)
+                {
+                    continue;
+                }
+
+                for(int it = 0; it < settings.iterations; ++it)
+                {
+                    BenchmarkCase benchCase;
+                    benchCase.distribution = *dist;
+                    benchCase.dimension = *dim;
+                    benchCase.numPoints = n;
+                    benchCase.iteration = it;
+
+                    // Generate the data set if it doesn't exist yet
+                    if(!std::ifstream(benchCase.GetFileName().c_str()).is_open())
+                    {
+                        dataGen.GenerateDataSet(*dist, *dim, n, it);
+                    }
+
+                    for(auto eps = settings.eps.cbegin(); eps != settings.eps.cend(); ++eps)
+                    {
+                        for(auto strategy = settings.strategies.cbegin(); strategy != settings.strategies.cend(); ++strategy)
+                        {
+                            for(auto scalar = settings.scalarTypes.cbegin(); scalar != settings.scalarTypes.cend(); ++scalar)
+                            {
+                                printf("Run %d: %s, D=%d, n=%d, iteration %d, eps=%g, %s, %s\n", numRuns, names[*dist], *dim, n, it,
+                                    *eps, strategyNames[*strategy], scalarTypeNames[*scalar]);
+
+                                std::ostringstream command;
+                                command << '"' << argv[0] << "\" --run " << numRuns << ' ' << names[*dist] << ' ' << *dim << ' '
+                                        << n << ' ' << it << ' ' << *eps << ' ' << strategyNames[*strategy] << ' '
+                                        << scalarTypeNames[*scalar] << sharedArgs.str();
+
+                                if(system(command.str().c_str()) != 0)
+                                {
+                                    printf("Run %d failed.\n", numRuns);
+                                    ++numFailed;
+                                }
+                                ++numRuns;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if(!MergeRunJson(settings, numRuns))
+    {
+        printf("Couldn't create \"%s.json\"\n", settings.out.c_str());
+        return -1;
+    }
+
+    printf("Finished %d of %d runs, results in %s.csv and %s.json\n", numRuns - numFailed, numRuns,
+        settings.out.c_str(), settings.out.c_str());
+
+    return (numFailed == 0 ? 0 : -1);
+}
@@ -13,13 +13,38 @@
 #include <stdlib.h>
 #include <algorithm>
 
+#ifdef _WSSD_THREADS_
+#include <thread>
+#endif //_WSSD_THREADS_
+
 #include "DataGen.h"
 
+// All distributions are scaled to the same range as the uniform one
+static const double kSide = double(1<<20);
+
+/**
+ * Maps a coordinate in [-1,1) to [0, kSide).
+ */
+static inline double ToSide(double x)
+{
+    return (x + 1.0) * (kSide / 2.0);
+}
+
 template< typename T >
-DataGen<T>::DataGen()
+DataGen<T>::DataGen(int numThreads)
 :	rd()
 ,	randomEngine(rd())
-{}
+,   numThreads(numThreads)
+{
+#ifdef _WSSD_THREADS_
+    if(this->numThreads <= 0)
+    {
+        this->numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+#else // ~_WSSD_THREADS_
+    this->numThreads = 1;
+#endif //_WSSD_THREADS_
+}
 
 template< typename T >
 void DataGen<T>::GenerateAllDataSets(int dim)
@@ -41,7 +66,12 @@ void DataGen<T>::GenerateDataSet(Distribution dist, int dim, int n, int iteratio
 {
 	FILE* fout;
 	char  filename[128];
-	T     val;
+
+    if(dist < 0 || dist >= kNumDistributions || dim < 1 || n < 0)
+    {
+        printf("Invalid distribution.\n");
+        return;
+    }
 
     // Open file
     // [OS] I think _s is microsoft specific, if this is the case, we should aim to find
@@ -49,185 +79,294 @@ void DataGen<T>::GenerateDataSet(Distribution dist, int dim, int n, int iteratio
     //      vulnerable to exploits.
     sprintf_s(filename, "%s_%i_%i_%i.bin", names[dist], dim, n, iteration);
     fopen_s(&fout, filename, "wb");
-	
-	if( fout )
+
+	if( !fout )
 	{
-		printf("Generating: %s\n", filename);
-		switch(dist)
-		{
-		case kUniform:
-			{
-				std::uniform_real_distribution<T> rng(0.0, T(1<<20));
-
-				for(int i=0; i < n; ++i)
-				{
-					for(int d=0; d<dim; ++d)
-					{
-						val = rng(randomEngine); 
-						fwrite(&val, 1, sizeof(T), fout);
-					}
-				}
-			}
-			break;
-		case kNormal:
-			{
-				std::normal_distribution<T> rng(T(1<<19), T(1<<13));
-
-				for(int i=0; i < n; ++i)
-				{
-					for(int d=0; d<dim; ++d)
-					{
-						val = rng(randomEngine); 
-						fwrite(&val, 1, sizeof(T), fout);
-					}
-				}
-			}
-			break;
-		//case kKuzmin:
-		//	{
-		//		float radius, random;
-		//		float rsq;
-		//		float fac;
-		//		float maximum = 0.0f;
-		//		float* xl = new float[n];
-		//		float* yl = new float[n];
-		//		float* zl = new float[n];
-
-		//		for(int i=0; i < n; ++i)
-		//		{
-		//			// Determine radius at which to place point
-		//			random = GetRandomFloat();
-		//			radius = sqrtf(1/(random*random) - 1);
-
-		//			// Find uniform dist point in sphere
-		//			do {
-		//				xl[i] = GetRandomFloatAroundZero();
-		//				yl[i] = GetRandomFloatAroundZero();
-		//				zl[i] = GetRandomFloatAroundZero();
-		//				rsq = xl[i]*xl[i] + yl[i]*yl[i] + zl[i]*zl[i];
-		//			} while(rsq >= 1.0f || rsq == 0.0f);
-		//			
-		//			// Rescale to put at radius
-		//			fac = radius/sqrtf(rsq);
-		//			xl[i] *= fac;
-		//			yl[i] *= fac;
-		//			zl[i] *= fac;
-
-		//			maximum = std::max(maximum, fabs(xl[i]));
-		//			maximum = std::max(maximum, fabs(yl[i]));
-		//			maximum = std::max(maximum, fabs(zl[i]));
-		//		}
-
-		//		// Rescale all point so they fit in [-1,1)
-		//		for(int i=0; i < n; ++i)
-		//		{
-		//			x = xl[i]/maximum;
-		//			y = yl[i]/maximum;
-		//			z = zl[i]/maximum;
-		//			WriteToFile(&x, &y, &z, fout);
-		//		}
-
-		//		delete[] xl;
-		//		delete[] yl;
-		//		delete[] zl;
-		//	}
-		//	break;
-		//case kPlane:
-		//	{
-		//		const float b = 0.001f;
-		//		for(int i=0; i < n; ++i)
-		//		{
-		//			x = GetRandomFloatAroundZero();
-		//			y = GetRandomFloatAroundZero();
-		//			z = GetRandomFloat();
-		//			z = -1.0f + (2*b)/(z - b*z + z);
-		//			WriteToFile(&x, &y, &z, fout);
-		//		}
-		//	}
-		//	break;
-		//case kCheckers:
-		//	{
-		//		for(int i=0; i < n; ++i)
-		//		{
-		//			x = GetRandomFloatAroundZero();
-		//			y = GetRandomFloatAroundZero();
-		//			z = GetRandomFloat();
-
-		//			if( ((int(x*8) + int(y*8)) % 2) != (int(z*4) % 2))
-		//			{
-		//				z = -z;
-		//			}
-
-		//			if(GetRandomFloat() < 0.125)
-		//			{
-		//				x = -x;
-		//				y = -y;
-		//				z = -z;
-		//			}
-
-		//			WriteToFile(&x, &y, &z, fout);
-		//		}
-		//	}
-		//	break;
-  //      case kMoment:
-  //          {
-  //              for(int i=0; i < n; ++i)
-  //              {
-  //                  t = GetRandomFloat();
-  //                  x = float(t * 2.0 - 1.0);
-  //                  y = float(t*t * 2.0 - 1.0);
-  //                  z = float(t*t*t * 2.0 - 1.0);
-  //                  WriteToFile(&x, &y, &z, fout);
-  //              }
-  //          }
-  //          break;
-  //      case kHelix:
-  //          {
-  //              float sqrtn = sqrtf(n);
-  //              for(int i=0; i < n; ++i)
-  //              {
-  //                  x = float((2.0 * kPi * i)/n);
-  //                  y = float(cos(2.0 * kPi * i / sqrtn) );
-  //                  z = float(sin(2.0 * kPi * i / sqrtn) );
-  //                  WriteToFile(&x, &y, &z, fout);
-  //              }
-  //          }
-  //          break;
-        case kSmallTestCase:
+		printf("Could not open or create: %s.\n", filename);
+		return;
+	}
+
+    printf("Generating: %s\n", filename);
+
+    // The test case consists of two circles of n/2 points
+    const long long numPoints = (dist == kSmallTestCase ? (n/2)*2 : n);
+
+    // Every chunk has its own stream, seeded with the data set seed and its index
+    const unsigned int seed = randomEngine();
+    Shape shape;
+    {
+        std::seed_seq shapeSeed(&seed, &seed + 1);
+        std::mt19937_64 shapeEngine(shapeSeed);
+        CreateShape(dist, dim, shapeEngine, shape);
+    }
+
+    // A round is generated in parallel and then written at once
+    const long long numChunks = (numPoints + kChunkSize - 1) / kChunkSize;
+    const long long chunksPerRound = std::min<long long>(std::max<long long>(numChunks, 1), 4*numThreads);
+    std::vector<T> buffer(std::size_t(chunksPerRound) * kChunkSize * dim);
+
+    for(long long round = 0; round < numChunks; round += chunksPerRound)
+    {
+        const long long roundChunks = std::min(chunksPerRound, numChunks - round);
+
+        auto generate = [&](int thread)
+        {
+            for(long long c = thread; c < roundChunks; c += numThreads)
+            {
+                const long long chunk = round + c;
+                const long long first = chunk * kChunkSize;
+
+                const unsigned int chunkSeeds[3] = { seed, (unsigned int)(chunk) + 1u, (unsigned int)(chunk >> 32) };
+                std::seed_seq chunkSeed(chunkSeeds, chunkSeeds + 3);
+                std::mt19937_64 engine(chunkSeed);
+                GenerateChunk(dist, dim, n, shape, engine, first, int(std::min<long long>(kChunkSize, numPoints - first)),
+                    &buffer[std::size_t(c) * kChunkSize * dim]);
+            }
+        };
+
+#ifdef _WSSD_THREADS_
+        std::vector<std::thread> threads;
+        for(int t = 1; t < numThreads; ++t)
+        {
+            threads.push_back(std::thread(generate, t));
+        }
+        generate(0);
+        for (auto& th : threads) th.join();
+#else // ~_WSSD_THREADS_
+        generate(0);
+#endif //_WSSD_THREADS_
+
+        // The chunks are contiguous, only the last chunk of the data set can be partial
+        const std::size_t roundPoints = std::size_t(std::min<long long>(roundChunks * kChunkSize, numPoints - round * kChunkSize));
+        if(fwrite(&buffer[0], sizeof(T) * dim, roundPoints, fout) != roundPoints)
+        {
+            printf("Could not write: %s.\n", filename);
+            break;
+        }
+    }
+
+	// Close file
+	fclose(fout);
+
+    printf("Done\n");
+}
+
+template< typename T >
+void DataGen<T>::CreateShape(Distribution dist, int dim, std::mt19937_64& engine, Shape& retShape) const
+{
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::uniform_real_distribution<double> angle(0.0, 2.0*M_PI);
+
+    switch(dist)
+    {
+    case kClustered:
+        {
+            // Cluster sizes range over four orders of magnitude, so the spread is large
+            std::uniform_real_distribution<double> scale(4.0, 18.0);
+            for(int i=0; i < kNumClusters; ++i)
+            {
+                for(int d=0; d < dim; ++d)
+                {
+                    retShape.centers.push_back(0.8 * unit(engine));
+                }
+                retShape.sigmas.push_back(pow(2.0, -scale(engine)));
+            }
+        }
+        break;
+    case kManifold:
+        {
+            // A closed surface (a curve in the plane) immersed by a sum of cosines
+            std::uniform_real_distribution<double> amplitude(0.5, 1.0);
+            std::uniform_int_distribution<int> frequency(1, 3);
+
+            retShape.manifoldDim = std::max(1, std::min(2, dim - 1));
+            for(int i=0; i < dim * retShape.manifoldDim; ++i)
+            {
+                retShape.amplitudes.push_back(amplitude(engine));
+                retShape.frequencies.push_back(frequency(engine));
+                retShape.phases.push_back(angle(engine));
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+template< typename T >
+void DataGen<T>::GenerateChunk(Distribution dist, int dim, int n, const Shape& shape, std::mt19937_64& engine,
+    long long first, int count, T* retCoords) const
+{
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::uniform_real_distribution<double> positive(0.0, 1.0);
+    std::normal_distribution<double> gaussian(0.0, 1.0);
+    std::uniform_int_distribution<int> cluster(0, kNumClusters - 1);
+    std::vector<double> p(dim);
+
+    for(int i=0; i < count; ++i)
+    {
+        const long long index = first + i;
+
+        switch(dist)
+        {
+        case kUniform:
+            {
+                for(int d=0; d<dim; ++d)
+                {
+                    p[d] = positive(engine) * kSide;
+                }
+            }
+            break;
+        case kNormal:
             {
-                std::uniform_real_distribution<double> rng(-M_PI, M_PI);
+                for(int d=0; d<dim; ++d)
+                {
+                    p[d] = kSide/2.0 + (kSide/128.0) * gaussian(engine);
+                }
+            }
+            break;
+        case kKuzmin:
+            {
+                // Radius of the Kuzmin disk, cut off at kMaxRadius so it can be scaled
+                // without knowing the furthest point
+                const double kMaxRadius = 1024.0;
+                const double minRandom = 1.0 / sqrt(1.0 + kMaxRadius*kMaxRadius);
+                double random;
+                do
+                {
+                    random = positive(engine);
+                } while(random <= minRandom);
+                const double radius = sqrt(1.0/(random*random) - 1.0);
 
-                T x, y;
+                // Uniform direction
+                double rsq;
+                do
+                {
+                    rsq = 0.0;
+                    for(int d=0; d<dim; ++d)
+                    {
+                        p[d] = gaussian(engine);
+                        rsq += p[d]*p[d];
+                    }
+                } while(rsq == 0.0);
+
+                const double fac = radius / (kMaxRadius * sqrt(rsq));
+                for(int d=0; d<dim; ++d)
+                {
+                    p[d] = ToSide(p[d] * fac);
+                }
+            }
+            break;
+        case kPlane:
+            {
+                // Dense near the plane of the last coordinate at -1
+                const double b = 0.001;
+                for(int d=0; d<dim-1; ++d)
+                {
+                    p[d] = ToSide(unit(engine));
+                }
+                p[dim-1] = ToSide(-1.0 + (2*b)/((1.0 - b)*positive(engine) + b));
+            }
+            break;
+        case kCheckers:
+            {
+                double z = positive(engine);
+                int cells = 0;
+                for(int d=0; d<dim-1; ++d)
+                {
+                    p[d] = unit(engine);
+                    cells += int(floor(p[d]*8));
+                }
+
+                if( (cells & 1) != (int(z*4) & 1) )
+                {
+                    z = -z;
+                }
+                p[dim-1] = z;
+
+                const bool mirror = (positive(engine) < 0.125);
+                for(int d=0; d<dim; ++d)
+                {
+                    p[d] = ToSide(mirror ? -p[d] : p[d]);
+                }
+            }
+            break;
+        case kMoment:
+            {
+                const double t = positive(engine);
+                double power = t;
+                for(int d=0; d<dim; ++d, power *= t)
+                {
+                    p[d] = ToSide(power * 2.0 - 1.0);
+                }
+            }
+            break;
+        case kHelix:
+            {
+                // The first coordinate moves along the axis, the others pairwise turn around it
+                const double turn = 2.0 * M_PI * index / sqrt(double(n));
+                p[0] = ToSide((2.0 * index + 1.0) / n - 1.0);
+                for(int d=1; d<dim; ++d)
+                {
+                    const double phase = turn * ((d+1)/2);
+                    p[d] = ToSide(0.99 * ((d & 1) ? cos(phase) : sin(phase)));
+                }
+            }
+            break;
+        case kSmallTestCase:
+            {
+                // Two concentric circles, the first half of the points on the inner one
+                const int r = (index < n/2 ? 0 : 1);
+                const double val = M_PI * unit(engine);
+                std::fill(p.begin(), p.end(), kSide/2.0);
+                p[0] = (1<<19) + (1<<18)*(0.9+r/10.0)*sin(val);
+                if(dim > 1)
+                {
+                    p[1] = (1<<19) + (1<<18)*(0.9+r/10.0)*cos(val);
+                }
+            }
+            break;
+        case kClustered:
+            {
+                const int c = cluster(engine);
+                for(int d=0; d<dim; ++d)
+                {
+                    p[d] = ToSide(shape.centers[c*dim + d] + shape.sigmas[c] * gaussian(engine));
+                }
+            }
+            break;
+        case kManifold:
+            {
+                double u[2];
+                for(int j=0; j < shape.manifoldDim; ++j)
+                {
+                    u[j] = M_PI * unit(engine);
+                }
 
-                for(int r = 0; r<2; r++)
+                // Slightly off the manifold
+                const double noise = 1.0 / (1<<12);
+                for(int d=0; d<dim; ++d)
                 {
-                    for(int i=0; i < n/2; ++i)
+                    double x = 0.0;
+                    for(int j=0; j < shape.manifoldDim; ++j)
                     {
-                        val = rng(randomEngine);
-                        x = (1<<19) + (1<<18)*(0.9+r/10.0)*sin(val);
-                        y = (1<<19) + (1<<18)*(0.9+r/10.0)*cos(val);
-                        fwrite(&x, 1, sizeof(T), fout);
-                        fwrite(&y, 1, sizeof(T), fout);
+                        const int term = d*shape.manifoldDim + j;
+                        x += shape.amplitudes[term] * cos(shape.frequencies[term] * u[j] + shape.phases[term]);
                     }
+                    p[d] = ToSide(0.9 * x / shape.manifoldDim + noise * gaussian(engine));
                 }
             }
             break;
-		case kNumDistributions:
-		default:
-			{
-				printf("Invalid distribution.\n");
-			}
-		}
-	}
-	else
-	{
-		printf("Could not open or create: %s.\n", filename);
-	}
-	// Close file
-	fclose(fout);
+        case kNumDistributions:
+        default:
+            break;
+        }
 
-    printf("Done\n");
-    getchar();
+        for(int d=0; d<dim; ++d)
+        {
+            retCoords[std::size_t(i)*dim + d] = T(p[d]);
+        }
+    }
 }
 
-template class DataGen<double>;
\ No newline at end of file
+template class DataGen<double>;
@@ -1,6 +1,9 @@
 /**
  * file: DataGen.h
- * desc: Generate some toy data to test with.
+ * desc: Generate some toy data to test with. The points are generated in chunks that each
+ *       have their own random stream, so a data set doesn't depend on the number of threads
+ *       that generate it. With _WSSD_THREADS_ the chunks are generated in parallel and written
+ *       a round of chunks at a time.
  *
  * Copyright 2013 Okke Schrijvers
  */
@@ -9,17 +12,20 @@
 #define __DATAGEN_H__
 
 #include <random>
+#include <vector>
 
 enum Distribution
 {
 	kUniform=0,
 	kNormal,
-	//kKuzmin,
-	//kPlane,
-	//kCheckers,
-    //kMoment,
-    //kHelix,
+	kKuzmin,
+	kPlane,
+	kCheckers,
+    kMoment,
+    kHelix,
     kSmallTestCase,
+    kClustered,
+    kManifold,
 
 	kNumDistributions
 
@@ -29,27 +35,68 @@ static const char* names[kNumDistributions] =
 {
 	"uniform",
 	"normal",
-	//"kuzmin",
-	//"plane",
-	//"checkers",
-    //"moment",
-    //"helix",
-    "testcase"
+	"kuzmin",
+	"plane",
+	"checkers",
+    "moment",
+    "helix",
+    "testcase",
+    "clustered",
+    "manifold"
 };
 
 template<typename T>
 class DataGen
 {
 private:
+    // Points per random stream
+    static const int kChunkSize = 1<<16;
+
+    // Gaussian clusters of kClustered
+    static const int kNumClusters = 32;
+
+    /**
+     * The random parts of a distribution that all chunks of a data set share.
+     */
+    struct Shape
+    {
+        std::vector<double> centers;        // kClustered: kNumClusters centers of 'dim' coordinates in [-1,1)
+        std::vector<double> sigmas;         // kClustered: standard deviation of each cluster
+
+        int                 manifoldDim;    // kManifold: intrinsic dimension
+        std::vector<double> amplitudes;     // kManifold: 'dim' x 'manifoldDim' terms of the embedding
+        std::vector<double> frequencies;
+        std::vector<double> phases;
+    };
 
 	// If available, this seeds the RNG with a truly random number
 	std::random_device	rd;
 	std::mt19937		randomEngine;
 
+    int                 numThreads;
+
 public:
-		  DataGen();
+    /**
+     * Generates with 'numThreads' threads, or one per core if it is 0.
+     */
+		  DataGen(int numThreads = 0);
+
+    /**
+     * Seed the data sets that are generated from now on, to reproduce them.
+     */
+    void  Seed(unsigned int seed) { randomEngine.seed(seed); }
+
 	void  GenerateAllDataSets(int dim);
 	void  GenerateDataSet(Distribution dist, int dim, int n, int iteration);
+
+private:
+    void  CreateShape(Distribution dist, int dim, std::mt19937_64& engine, Shape& retShape) const;
+
+    /**
+     * Writes the 'dim' coordinates of the points [first, first+count) of the data set to 'retCoords'.
+     */
+    void  GenerateChunk(Distribution dist, int dim, int n, const Shape& shape, std::mt19937_64& engine,
+              long long first, int count, T* retCoords) const;
 };
 
-#endif //__DATAGEN_H__
\ No newline at end of file
+#endif //__DATAGEN_H__
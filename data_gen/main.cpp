@@ -5,13 +5,50 @@
  * Copyright 2013 Okke Schrijvers
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "DataGen.h"
 
-int main(void)
+int main(int argc, char** argv)
 {
-	// Generate a dataset
-	DataGen<double> dg;
-	dg.GenerateDataSet(kSmallTestCase, 2, 200, 0);
+	// Without arguments, generate the small test case
+	if(argc == 1)
+	{
+		DataGen<double> dg;
+		dg.GenerateDataSet(kSmallTestCase, 2, 200, 0);
+
+		printf("Press enter to continue...\n");
+		getchar();
+
+		return 0;
+	}
+
+	// data_gen <distribution> <dimension> <n> [iteration] [threads] [seed]
+	int dist = 0;
+	while(dist < kNumDistributions && strcmp(argv[1], names[dist]) != 0)
+	{
+		++dist;
+	}
+
+	if(argc < 4 || argc > 7 || dist == kNumDistributions)
+	{
+		printf("Usage: data_gen <distribution> <dimension> <n> [iteration] [threads] [seed]\nDistributions:");
+		for(int i = 0; i < kNumDistributions; ++i)
+		{
+			printf(" %s", names[i]);
+		}
+		printf("\n");
+		return -1;
+	}
+
+	DataGen<double> dg(argc > 5 ? atoi(argv[5]) : 0);
+	if(argc > 6)
+	{
+		dg.Seed((unsigned int)(strtoul(argv[6], NULL, 10)));
+	}
+	dg.GenerateDataSet(Distribution(dist), atoi(argv[2]), atoi(argv[3]), argc > 4 ? atoi(argv[4]) : 0);
 
 	return 0;
 }
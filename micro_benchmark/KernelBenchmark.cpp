@@ -0,0 +1,290 @@
+/**
+ * file: KernelBenchmark.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+#include "CpuTimer.h"
+#include "Quadtree.h"
+#include "QuadtreeConstructor.h"
+#include "WspdConstructor.h"
+#include "WssdConstructor.h"
+#include "FiltrationConstructor.h"
+
+#include "KernelBenchmark.h"
+#include "Instantiations.h"
+
+template<typename T, int D>
+KernelBenchmark<T,D>::KernelBenchmark(double eps, double minTimeMs)
+: eps(eps)
+, minTimeMs(minTimeMs)
+, root(NULL)
+, sink(0.0)
+{}
+
+template<typename T, int D>
+KernelBenchmark<T,D>::~KernelBenchmark()
+{
+    clear();
+}
+
+template<typename T, int D>
+bool KernelBenchmark<T,D>::Load(const std::string& name, const std::vector<vec<T,D>>& pointSet, std::size_t maxPairs, std::size_t maxTuples)
+{
+    clear();
+
+    if(pointSet.empty())
+    {
+        return false;
+    }
+
+    // Same settings as main.cpp
+    const double eta = eps / 5.0;
+    const double wspdEta = eta / 2.0;
+    const double maxAlpha = std::numeric_limits<double>::infinity();
+
+    inputName = name;
+    points = pointSet;
+
+    QuadtreeConstructor<T,D> constructor;
+    root = constructor.ConstructQuadtree(points);
+    constructor.CompressQuadtree(root);
+
+    KWSSD(T,D,1) pairs;
+    WspdConstructor<T,D> wspdConstructor(wspdEta, maxAlpha);
+    wspdConstructor.ConstructWspd(root, pairs);
+
+    // The pairs tested by the WSPD construction: the ones that are well-separated, and the
+    // pairs of their parents that were not
+    std::size_t stride = std::max<std::size_t>(1, pairs.size() / std::max<std::size_t>(1, maxPairs / 2));
+    for(std::size_t i = 0; i < pairs.size(); i += stride)
+    {
+        testedPairs.push_back(std::make_pair(pairs[i][0], pairs[i][1]));
+        if(pairs[i][0]->GetParent())
+        {
+            testedPairs.push_back(std::make_pair(pairs[i][0]->GetParent(), pairs[i][1]));
+        }
+    }
+
+    // Extend an evenly spread sample of the pairs, the full 2-WSSD is much larger than needed
+    stride = std::max<std::size_t>(1, pairs.size() / std::max<std::size_t>(1, maxTuples / 8));
+    for(std::size_t i = 0; i < pairs.size(); i += stride)
+    {
+        sampledPairs.push_back(pairs[i]);
+    }
+    const std::size_t numPairs = pairs.size();
+    KWSSD(T,D,1)().swap(pairs);
+
+    WssdConstructor<T,D,2> wssd2Constructor(eta, maxAlpha);
+    wssd2Constructor.ConstructWssd(sampledPairs, root, tuples);
+    if(tuples.size() > maxTuples)
+    {
+        tuples.erase(tuples.begin() + maxTuples, tuples.end());
+    }
+
+    // Highest ancestor of every leaf, for cell diameters from the whole quadtree down to a cell
+    // 2^-20 of its size
+    const double rootDiam = root->GetAabb().GetDiameter();
+    std::vector<Quadtree<T,D>*> stack(1, root);
+    int numQueries = 0;
+    while(!stack.empty())
+    {
+        Quadtree<T,D>* node = stack.back();
+        stack.pop_back();
+
+        if(node->IsLeaf())
+        {
+            ancestorQueries.push_back(std::make_pair(node, ldexp(rootDiam, -(numQueries++ % 21))));
+        }
+        for(Quadtree<T,D>::ChildIterator it = node->ChildBegin(); it != node->ChildEnd(); ++it)
+        {
+            stack.push_back(*it);
+        }
+    }
+
+    // The nodes of the 2-tuples, as passed to GetDiam, and the triangles and edges they span
+    std::mt19937 randomEngine(5489u);
+    std::uniform_int_distribution<std::size_t> randomTuple(0, std::max<std::size_t>(1, tuples.size()) - 1);
+    std::vector<Quadtree<T,D>*> vertices;
+
+    for(auto it = tuples.cbegin(); it != tuples.cend(); ++it)
+    {
+        std::set<Quadtree<T,D>*> nodes;
+        for(int j = 0; j < 3; ++j)
+        {
+            nodes.insert((*it)[j]);
+        }
+        nodeSets.push_back(nodes);
+
+        vertices.assign(nodes.begin(), nodes.end());
+        Simplex<T,D>* simplex = new Simplex<T,D>(vertices);
+        if(!simplices.insert(simplex).second)
+        {
+            delete simplex;
+        }
+
+        if(nodes.size() > 2)
+        {
+            vertices.pop_back();
+            simplex = new Simplex<T,D>(vertices);
+            if(!simplices.insert(simplex).second)
+            {
+                delete simplex;
+            }
+        }
+    }
+
+    // A copy of every simplex, and one with a vertex of another tuple, which is nearly always missing
+    for(auto it = simplices.cbegin(); it != simplices.cend(); ++it)
+    {
+        probes.push_back(new Simplex<T,D>((*it)->GetVertices()));
+
+        vertices = (*it)->GetVertices();
+        vertices[0] = tuples[randomTuple(randomEngine)][0];
+        std::sort(vertices.begin(), vertices.end());
+        if(std::unique(vertices.begin(), vertices.end()) != vertices.end())
+        {
+            vertices = (*it)->GetVertices();
+        }
+        probes.push_back(new Simplex<T,D>(vertices));
+    }
+    std::shuffle(probes.begin(), probes.end(), randomEngine);
+
+    printf("%s: %u points, %u pairs, %u 2-tuples, %u simplices\n", inputName.c_str(), (unsigned int)(points.size()),
+        (unsigned int)(numPairs), (unsigned int)(tuples.size()), (unsigned int)(simplices.size()));
+
+    return true;
+}
+
+template<typename T, int D>
+void KernelBenchmark<T,D>::Run(std::vector<KernelResult>& retResults)
+{
+    const double eta = eps / 5.0;
+    WspdConstructor<T,D> wspdConstructor(eta / 2.0);
+    FiltrationConstructor<T,D> filtrationConstructor(eps, 0, 0);
+
+    retResults.push_back(Measure("WspdConstructor::WellSeparated", testedPairs.size(), [&]() -> double
+    {
+        double count = 0.0;
+        for(auto it = testedPairs.cbegin(); it != testedPairs.cend(); ++it)
+        {
+            count += wspdConstructor.WellSeparated(it->first, it->second);
+        }
+        return count;
+    }));
+
+    retResults.push_back(Measure("AxisAlignedBoundingBox::DistanceTo(box)", testedPairs.size(), [&]() -> double
+    {
+        double sum = 0.0;
+        for(auto it = testedPairs.cbegin(); it != testedPairs.cend(); ++it)
+        {
+            sum += it->first->GetAabb().DistanceTo(it->second->GetAabb());
+        }
+        return sum;
+    }));
+
+    retResults.push_back(Measure("AxisAlignedBoundingBox::DistanceTo(point)", testedPairs.size(), [&]() -> double
+    {
+        double sum = 0.0;
+        std::size_t i = 0;
+        for(auto it = testedPairs.cbegin(); it != testedPairs.cend(); ++it, ++i)
+        {
+            sum += it->first->GetAabb().DistanceTo(points[i % points.size()]);
+        }
+        return sum;
+    }));
+
+    retResults.push_back(Measure("FiltrationConstructor::GetDiam", nodeSets.size(), [&]() -> double
+    {
+        double sum = 0.0;
+        for(auto it = nodeSets.cbegin(); it != nodeSets.cend(); ++it)
+        {
+            sum += filtrationConstructor.GetDiam(*it);
+        }
+        return sum;
+    }));
+
+    retResults.push_back(Measure("FiltrationConstructor::GetHighestAncestor", ancestorQueries.size(), [&]() -> double
+    {
+        double sum = 0.0;
+        for(auto it = ancestorQueries.cbegin(); it != ancestorQueries.cend(); ++it)
+        {
+            sum += filtrationConstructor.GetHighestAncestor(it->first, it->second)->GetAabb().GetDiameter();
+        }
+        return sum;
+    }));
+
+    retResults.push_back(Measure("std::set<Simplex*>::find", probes.size(), [&]() -> double
+    {
+        double found = 0.0;
+        for(auto it = probes.cbegin(); it != probes.cend(); ++it)
+        {
+            found += (simplices.find(*it) != simplices.end());
+        }
+        return found;
+    }));
+}
+
+template<typename T, int D>
+template<typename Kernel>
+KernelResult KernelBenchmark<T,D>::Measure(const std::string& name, std::size_t opsPerCall, Kernel kernel)
+{
+    KernelResult result;
+    result.kernel = name;
+    result.input = inputName;
+    result.ops = 0;
+    result.ms = 0.0;
+
+    if(opsPerCall == 0)
+    {
+        return result;
+    }
+
+    // Warm up the caches and branch predictors
+    sink += kernel();
+
+    CpuTimer timer;
+    do
+    {
+        timer.Start();
+        sink += kernel();
+        result.ms += timer.Stop();
+        result.ops += opsPerCall;
+    } while(result.ms < minTimeMs);
+
+    return result;
+}
+
+template<typename T, int D>
+void KernelBenchmark<T,D>::clear()
+{
+    for(auto it = simplices.begin(); it != simplices.end(); ++it)
+    {
+        delete *it;
+    }
+    for(auto it = probes.begin(); it != probes.end(); ++it)
+    {
+        delete *it;
+    }
+    simplices.clear();
+    probes.clear();
+
+    nodeSets.clear();
+    ancestorQueries.clear();
+    testedPairs.clear();
+    tuples.clear();
+    sampledPairs.clear();
+
+    delete root;
+    root = NULL;
+    points.clear();
+}
+
+#define INSTANTIATE_KERNEL_BENCHMARK(T,D) template class KernelBenchmark<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_KERNEL_BENCHMARK)
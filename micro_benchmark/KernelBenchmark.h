@@ -0,0 +1,92 @@
+/**
+ * file: KernelBenchmark.h
+ * desc: Micro-benchmarks of the kernels that dominate the construction: the well-separation
+ *       test of the WSPD, bounding box distances, the minimum enclosing ball of a tuple, the
+ *       highest ancestor search and the simplex lookup of the filtration. The inputs are
+ *       captured from a real point set: its compressed quadtree, WSPD and part of its 2-WSSD.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _KERNEL_BENCHMARK_H_
+#define _KERNEL_BENCHMARK_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Simplex.h"
+#include "WellSeparatedTuple.h"
+
+/**
+ * Time spent on a number of calls of a kernel.
+ */
+struct KernelResult
+{
+    std::string         kernel;
+    std::string         input;
+    unsigned long long  ops;
+    double              ms;
+
+    double GetNsPerOp() const  { return (ops > 0 ? 1e6 * ms / ops : 0.0); }
+    double GetOpsPerSec() const { return (ms > 0 ? 1e3 * ops / ms : 0.0); }
+};
+
+template<typename T, int D>
+class KernelBenchmark
+{
+// Fields
+private:
+    double                              eps;
+    double                              minTimeMs;      // Each kernel is repeated for at least this long
+
+    std::string                         inputName;
+    std::vector<vec<T,D>>               points;
+    Quadtree<T,D>*                      root;
+
+    // Captured inputs
+    KWSSD(T,D,1)                        sampledPairs;   // Evenly spread subset of the WSPD, extended to 'tuples'
+    KWSSD(T,D,2)                        tuples;
+    std::vector<std::pair<Quadtree<T,D>*, Quadtree<T,D>*>>  testedPairs;    // Sample of the WSPD pairs and their parents
+    std::vector<std::pair<Quadtree<T,D>*, double>>          ancestorQueries;
+    std::vector<std::set<Quadtree<T,D>*>>                   nodeSets;
+    std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator>  simplices;  // Owned
+    std::vector<Simplex<T,D>*>                              probes;         // Owned, half of them match a simplex in 'simplices'
+
+    // Results of the kernels are accumulated, so the calls can't be optimized away
+    double                              sink;
+
+// Constructors
+public:
+    KernelBenchmark(double eps, double minTimeMs);
+    ~KernelBenchmark();
+
+// Functions
+public:
+    /**
+     * Builds the quadtree, WSPD and 2-WSSD of 'pointSet' with the settings of main.cpp and
+     * captures the inputs of the kernels. At most 'maxTuples' 2-tuples and 'maxPairs' pairs
+     * are kept.
+     * Returns false if the point set is empty.
+     */
+    bool Load(const std::string& name, const std::vector<vec<T,D>>& pointSet, std::size_t maxPairs, std::size_t maxTuples);
+
+    /**
+     * Runs every kernel on the captured inputs and appends the results.
+     */
+    void Run(std::vector<KernelResult>& retResults);
+
+private:
+    /**
+     * Calls 'kernel', which handles 'opsPerCall' inputs, until at least minTimeMs has passed.
+     */
+    template<typename Kernel>
+    KernelResult Measure(const std::string& name, std::size_t opsPerCall, Kernel kernel);
+
+    /**
+     * Frees the captured inputs and the quadtree.
+     */
+    void clear();
+};
+
+#endif //_KERNEL_BENCHMARK_H_
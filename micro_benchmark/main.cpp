@@ -0,0 +1,155 @@
+/**
+ * file: main.cpp
+ * desc: Micro-benchmarks of the hot kernels, on inputs captured from the bundled 3D data sets.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "PointSetIO.h"
+#include "KernelBenchmark.h"
+
+/**
+ * Reads a binary point set of S-typed points and converts them to T. Points that coincide
+ * are merged, since the quadtree needs distinct points.
+ */
+template<typename S, typename T, int D>
+static bool ReadDataSet(const std::string& fileName, std::vector<vec<T,D>>& retPoints)
+{
+    std::vector<vec<S,D>> source;
+    if(!PointSetIO<S,D>().ReadFromFile(fileName, source, kBinary, false))
+    {
+        return false;
+    }
+
+    retPoints.resize(source.size());
+    for(std::size_t i = 0; i < source.size(); ++i)
+    {
+        for(int d = 0; d < D; ++d)
+        {
+            retPoints[i][d] = T(source[i][d]);
+        }
+    }
+
+    auto less = [](const vec<T,D>& lhs, const vec<T,D>& rhs) -> bool
+    {
+        for(int d = 0; d < D; ++d)
+        {
+            if(lhs[d] != rhs[d])
+            {
+                return lhs[d] < rhs[d];
+            }
+        }
+        return false;
+    };
+    auto equal = [&](const vec<T,D>& lhs, const vec<T,D>& rhs) -> bool
+    {
+        return !less(lhs, rhs) && !less(rhs, lhs);
+    };
+
+    std::sort(retPoints.begin(), retPoints.end(), less);
+    retPoints.erase(std::unique(retPoints.begin(), retPoints.end(), equal), retPoints.end());
+
+    return !retPoints.empty();
+}
+
+int main(int argc, char** argv)
+{
+    typedef double T;
+    const int dimension = 3;
+
+    std::string dataDir = "../data";
+    std::string csvFile;
+    double eps = 1.0;
+    double minTimeMs = 200.0;
+    std::size_t maxPairs = 1<<20;
+    std::size_t maxTuples = 100000;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--data" && i + 1 < argc)
+        {
+            dataDir = argv[++i];
+        }
+        else if(arg == "--eps" && i + 1 < argc)
+        {
+            eps = atof(argv[++i]);
+        }
+        else if(arg == "--min-time" && i + 1 < argc)
+        {
+            minTimeMs = atof(argv[++i]);
+        }
+        else if(arg == "--max-pairs" && i + 1 < argc)
+        {
+            maxPairs = std::size_t(atoi(argv[++i]));
+        }
+        else if(arg == "--max-tuples" && i + 1 < argc)
+        {
+            maxTuples = std::size_t(atoi(argv[++i]));
+        }
+        else if(arg == "--csv" && i + 1 < argc)
+        {
+            csvFile = argv[++i];
+        }
+        else
+        {
+            printf("Usage: micro_benchmark [--data <dir>] [--eps <eps>] [--min-time <ms>] [--max-pairs <n>] [--max-tuples <n>] [--csv <file>]\n");
+            return -1;
+        }
+    }
+
+    // The bunny is stored as floats, the uniform points as doubles
+    std::vector<vec<T,dimension>> bunny;
+    std::vector<vec<T,dimension>> uniform;
+    if(!ReadDataSet<float>(dataDir + "/bunny.bin", bunny) ||
+       !ReadDataSet<double>(dataDir + "/uniform_3_10000.bin", uniform))
+    {
+        printf("Couldn't read the data sets in \"%s\"\n", dataDir.c_str());
+        return -1;
+    }
+
+    std::vector<KernelResult> results;
+    KernelBenchmark<T,dimension> benchmark(eps, minTimeMs);
+
+    if(benchmark.Load("bunny", bunny, maxPairs, maxTuples))
+    {
+        benchmark.Run(results);
+    }
+    if(benchmark.Load("uniform_3_10000", uniform, maxPairs, maxTuples))
+    {
+        benchmark.Run(results);
+    }
+
+    printf("\n%-44s %-16s %12s %14s\n", "kernel", "input", "ns/op", "ops/s");
+    for(auto it = results.cbegin(); it != results.cend(); ++it)
+    {
+        printf("%-44s %-16s %12.2f %14.0f\n", it->kernel.c_str(), it->input.c_str(), it->GetNsPerOp(), it->GetOpsPerSec());
+    }
+
+    if(!csvFile.empty())
+    {
+        std::ofstream file(csvFile.c_str(), std::ios::out | std::ios::trunc);
+        if(!file.is_open())
+        {
+            printf("Couldn't create \"%s\"\n", csvFile.c_str());
+            return -1;
+        }
+
+        file << "kernel,input,ops,ms,ns_per_op,ops_per_sec" << std::endl;
+        for(auto it = results.cbegin(); it != results.cend(); ++it)
+        {
+            char buffer[128];
+            sprintf_s(buffer, "%llu,%.3f,%.3f,%.0f", it->ops, it->ms, it->GetNsPerOp(), it->GetOpsPerSec());
+            file << it->kernel << ',' << it->input << ',' << buffer << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * file: AncestorIndex.h
+ * desc: Index of the quadtree nodes that contain a set of points, for validating a WSSD on a
+ *       sample of the points. A tuple of points is represented by a tuple of the WSSD whose
+ *       nodes are ancestors of the leaves of the points, so looking up the nodes of every tuple
+ *       in the index finds the points they represent. Takes O(points * depth) time and space.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _ANCESTOR_INDEX_H_
+#define _ANCESTOR_INDEX_H_
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WSSD_THREADS_
+#include <thread>
+#endif //_WSSD_THREADS_
+
+#include "Quadtree.h"
+#include "Vec.h"
+
+/**
+ * Number of threads to split work over, one if compiled without _WSSD_THREADS_.
+ */
+inline int GetNumWorkThreads()
+{
+#ifdef _WSSD_THREADS_
+    return std::max(1, int(std::thread::hardware_concurrency()));
+#else // ~_WSSD_THREADS_
+    return 1;
+#endif //_WSSD_THREADS_
+}
+
+/**
+ * Calls body(begin, end, thread) on consecutive ranges of [0, size), one per thread.
+ */
+template<typename Body>
+void ParallelFor(std::size_t size, int numThreads, Body body)
+{
+#ifdef _WSSD_THREADS_
+    std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; ++t)
+    {
+        threads.push_back(std::thread(body, size*t/numThreads, size*(t+1)/numThreads, t));
+    }
+    for (auto& th : threads) th.join();
+#else // ~_WSSD_THREADS_
+    body(std::size_t(0), size, 0);
+#endif //_WSSD_THREADS_
+}
+
+template<typename T, int D>
+class AncestorIndex
+{
+// Fields
+private:
+    // Indices of the points below each node, in ascending order
+    std::unordered_map<const Quadtree<T,D>*, std::vector<std::size_t>>  pointsBelow;
+
+// Functions
+public:
+    /**
+     * Indexes the ancestors of the leaves of 'points' in the quadtree of 'root'. Returns the
+     * number of points that aren't stored in the quadtree, they are left out.
+     */
+    std::size_t Build(const Quadtree<T,D>* root, const std::vector<vec<T,D>*>& points, int numThreads)
+    {
+        pointsBelow.clear();
+
+        // Find the leaf of every point
+        std::vector<const Quadtree<T,D>*> leaves(points.size());
+        ParallelFor(leaves.size(), numThreads, [&](std::size_t begin, std::size_t end, int)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                leaves[i] = root->FindLeafNode(points[i]);
+            }
+        });
+
+        // The lists stay sorted since the points are added in order
+        std::size_t notFound = 0;
+        for(std::size_t i = 0; i < leaves.size(); ++i)
+        {
+            if(leaves[i] == NULL || leaves[i]->GetPoint() != points[i])
+            {
+                ++notFound;
+                continue;
+            }
+
+            for(const Quadtree<T,D>* node = leaves[i]; node != NULL; node = node->GetParent())
+            {
+                pointsBelow[node].push_back(i);
+            }
+        }
+
+        return notFound;
+    }
+
+    /**
+     * The indices of the points below 'node' in ascending order, or NULL if there are none.
+     */
+    const std::vector<std::size_t>* Find(const Quadtree<T,D>* node) const
+    {
+        auto it = pointsBelow.find(node);
+        return (it != pointsBelow.end() ? &it->second : NULL);
+    }
+};
+
+#endif //_ANCESTOR_INDEX_H_
@@ -10,6 +10,7 @@
 
 #include "Orthant.h"
 #include "Vec.h"
+#include "VecKernels.h"
 
 /**
  * Class to hold D-dimensional point of type T.
@@ -42,37 +43,56 @@ public:
         this->max = max;
     }
 
+    // The kernels work on the coordinates directly, so the traversals don't need vec
+    // temporaries or calls into Vec.cpp.
     void Extend(const AxisAlignedBoundingBox<T,D>& rhs)
     {
-        min.MinExtend(rhs.min);
-        max.MaxExtend(rhs.max);
+        VecKernels<T,D>::Min(&min[0], &rhs.min[0], &min[0]);
+        VecKernels<T,D>::Max(&max[0], &rhs.max[0], &max[0]);
     }
 
     double DistanceTo(const vec<T,D>& rhs) const
     {
-        return (rhs - rhs.Clamped(min, max)).Length();
+        T gap[D];
+        VecKernels<T,D>::PointGap(&rhs[0], &min[0], &max[0], gap);
+        return sqrt(VecKernels<T,D>::SquaredLength(gap));
     }
 
     double DistanceTo(const AxisAlignedBoundingBox<T,D>& rhs) const
     {
-        // Initialize the distance vector to the 0 vector
-        vec<T,D> distance;
+        // The shortest distance in each dimension, 0 where they overlap
+        T gap[D];
+        VecKernels<T,D>::BoxGap(&min[0], &max[0], &rhs.min[0], &rhs.max[0], gap);
+        return sqrt(VecKernels<T,D>::SquaredLength(gap));
+    }
 
-        // Find the shortest distance in each dimension
-        for(int d=0;d<D;++d)
+    /**
+     * DistanceTo of this box to each of 'boxes', in 'retDistances'. This box is copied once,
+     * so it stays in registers, and the boxes are independent, so their loads overlap.
+     */
+    void DistancesTo(const AxisAlignedBoundingBox<T,D>* const* boxes, int count, double* retDistances) const
+    {
+        const AxisAlignedBoundingBox<T,D> box(*this);
+        for(int i=0; i<count; ++i)
         {
-            if(max[d] < rhs.min[d])
-            {
-                distance[d] = rhs.min[d] - max[d];
-            }
-            else if(rhs.max[d] < min[d])
-            {
-                distance[d] = min[d] - rhs.max[d];
-            }
-            // else they overlap and distance of 0 is correct.
+            T gap[D];
+            VecKernels<T,D>::BoxGap(&box.min[0], &box.max[0], &boxes[i]->min[0], &boxes[i]->max[0], gap);
+            retDistances[i] = sqrt(VecKernels<T,D>::SquaredLength(gap));
         }
+    }
 
-        return distance.Length();
+    /**
+     * DistanceTo of 'point' to each of 'boxes', in 'retDistances'.
+     */
+    static void DistancesTo(const vec<T,D>& point, const AxisAlignedBoundingBox<T,D>* const* boxes, int count, double* retDistances)
+    {
+        const vec<T,D> p(point);
+        for(int i=0; i<count; ++i)
+        {
+            T gap[D];
+            VecKernels<T,D>::PointGap(&p[0], &boxes[i]->min[0], &boxes[i]->max[0], gap);
+            retDistances[i] = sqrt(VecKernels<T,D>::SquaredLength(gap));
+        }
     }
 
     vec<T,D> GetMidPoint() const
@@ -84,7 +104,9 @@ public:
     {
         // [OS] we might store the diameter at some point.
         //      If so, perform correctness assert here.
-        return (max-min).Length();
+        T extent[D];
+        VecKernels<T,D>::Sub(&max[0], &min[0], extent);
+        return sqrt(VecKernels<T,D>::SquaredLength(extent));
     }
 
     /**
@@ -0,0 +1,144 @@
+/**
+ * file: BinaryFiltration.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "BinaryFiltration.h"
+
+// Read the file in chunks of this many bytes
+static const std::size_t kReadBufferSize = 1 << 22;
+
+bool BinaryFiltrationReader::ReadHeader(const std::string& filename, BinaryFiltrationHeader& retHeader) const
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if(!file.is_open())
+    {
+        printf("File \"%s\" couldn't be opened.\n", filename.c_str());
+        return false;
+    }
+
+    return ReadHeader(file, retHeader);
+}
+
+bool BinaryFiltrationReader::ReadHeader(std::istream& file, BinaryFiltrationHeader& retHeader) const
+{
+    char magic[8];
+    std::uint32_t version;
+
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&retHeader.valueBytes, sizeof(retHeader.valueBytes));
+    file.read((char*)&retHeader.maxDimension, sizeof(retHeader.maxDimension));
+    file.read((char*)&retHeader.recordBytes, sizeof(retHeader.recordBytes));
+    file.read((char*)&retHeader.numSimplices, sizeof(retHeader.numSimplices));
+
+    if(!file || memcmp(magic, kBinaryFiltrationMagic, sizeof(magic)) != 0)
+    {
+        printf("Not a binary filtration file.\n");
+        return false;
+    }
+    if(version != kBinaryFiltrationVersion)
+    {
+        printf("Unsupported binary filtration version %u.\n", version);
+        return false;
+    }
+    if((retHeader.valueBytes != sizeof(float) && retHeader.valueBytes != sizeof(double)) ||
+        retHeader.maxDimension > kMaxBinaryFiltrationDimension ||
+        retHeader.recordBytes != 4 + retHeader.valueBytes + 4*(retHeader.maxDimension + 1))
+    {
+        printf("Corrupt binary filtration header.\n");
+        return false;
+    }
+
+    retHeader.counts.resize(retHeader.maxDimension + 1);
+    file.read((char*)&retHeader.counts[0], retHeader.counts.size()*sizeof(std::uint64_t));
+
+    return !file.fail();
+}
+
+bool BinaryFiltrationReader::Read(const std::string& filename, BinaryFiltration& retFiltration) const
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if(!file.is_open())
+    {
+        printf("File \"%s\" couldn't be opened.\n", filename.c_str());
+        return false;
+    }
+
+    BinaryFiltrationHeader header;
+    if(!ReadHeader(file, header))
+    {
+        return false;
+    }
+
+    // Reserve everything up front, the counts tell exactly how many boundary indices there are
+    std::uint64_t numBoundaries = 0;
+    for(std::uint32_t d=1; d<header.counts.size(); ++d)
+    {
+        numBoundaries += header.counts[d]*(d+1);
+    }
+
+    retFiltration.dimensions.resize(header.numSimplices);
+    retFiltration.values.resize(header.numSimplices);
+    retFiltration.boundaryOffsets.resize(header.numSimplices + 1);
+    retFiltration.boundaries.resize(numBoundaries);
+
+    // Read whole records in large chunks
+    const std::size_t recordsPerChunk = std::max<std::size_t>(1, kReadBufferSize/header.recordBytes);
+    std::vector<char> buffer(recordsPerChunk*header.recordBytes);
+
+    std::uint64_t numRead = 0;
+    std::uint64_t boundaryOffset = 0;
+    while(numRead < header.numSimplices)
+    {
+        std::size_t numRecords = std::size_t(std::min<std::uint64_t>(recordsPerChunk, header.numSimplices - numRead));
+        file.read(&buffer[0], numRecords*header.recordBytes);
+        if(!file)
+        {
+            printf("Unexpected end of binary filtration file.\n");
+            return false;
+        }
+
+        const char* record = &buffer[0];
+        for(std::size_t r=0; r<numRecords; ++r, ++numRead, record += header.recordBytes)
+        {
+            std::uint32_t dimension;
+            memcpy(&dimension, record, 4);
+
+            if(dimension > header.maxDimension || boundaryOffset + (dimension > 0 ? dimension+1 : 0) > numBoundaries)
+            {
+                printf("Corrupt record %llu in binary filtration file.\n", (unsigned long long)numRead);
+                return false;
+            }
+
+            if(header.valueBytes == sizeof(float))
+            {
+                float value;
+                memcpy(&value, record + 4, sizeof(float));
+                retFiltration.values[numRead] = value;
+            }
+            else
+            {
+                memcpy(&retFiltration.values[numRead], record + 4, sizeof(double));
+            }
+
+            retFiltration.dimensions[numRead] = dimension;
+            retFiltration.boundaryOffsets[numRead] = boundaryOffset;
+
+            if(dimension > 0)
+            {
+                memcpy(&retFiltration.boundaries[boundaryOffset], record + 4 + header.valueBytes, 4*(dimension+1));
+                boundaryOffset += dimension+1;
+            }
+        }
+    }
+    retFiltration.boundaryOffsets[header.numSimplices] = boundaryOffset;
+
+    return true;
+}
@@ -0,0 +1,89 @@
+/**
+ * file: BinaryFiltration.h
+ * desc: Binary filtration format written by Exporter::ExportBinary, and a reader for it that
+ *       does not depend on the rest of the code, so downstream tools only need this file and
+ *       BinaryFiltration.cpp.
+ *
+ *       Values are stored in host byte order, little-endian on x86. The file starts with a header:
+ *
+ *         char[8]   magic "WSSDFILT"
+ *         uint32    version
+ *         uint32    value size in bytes (4 for float, 8 for double)
+ *         uint32    maximal dimension of a simplex (maxDim), at most kMaxBinaryFiltrationDimension
+ *         uint32    record size in bytes
+ *         uint64    number of simplices
+ *         uint64    number of simplices of dimension 0, ..., maxDim
+ *
+ *       followed by one fixed-width record per simplex in filtration order:
+ *
+ *         uint32    dimension d
+ *         value     function value (alpha, i.e. half the diameter)
+ *         uint32    (maxDim+1) indices of the boundary simplices, unused slots are kNoBoundary
+ *
+ *       Boundary indices are 0-based record indices. Vertices have no boundary.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _BINARY_FILTRATION_H_
+#define _BINARY_FILTRATION_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+static const char          kBinaryFiltrationMagic[8] = {'W','S','S','D','F','I','L','T'};
+static const std::uint32_t kBinaryFiltrationVersion  = 1;
+static const std::uint32_t kNoBoundary               = 0xFFFFFFFF;
+
+// Larger maximal dimensions in a header are rejected as corrupt, also keeps maxDim+1 from wrapping
+static const std::uint32_t kMaxBinaryFiltrationDimension = 64;
+
+/**
+ * Header of a binary filtration file.
+ */
+struct BinaryFiltrationHeader
+{
+    std::uint32_t               valueBytes;
+    std::uint32_t               maxDimension;
+    std::uint32_t               recordBytes;
+    std::uint64_t               numSimplices;
+    std::vector<std::uint64_t>  counts;     // Number of simplices per dimension
+
+    /**
+     * Number of bytes the header occupies in the file.
+     */
+    std::size_t GetSize() const { return 8 + 4*4 + 8 + 8*counts.size(); }
+};
+
+/**
+ * A filtration loaded from a binary file. The boundary of simplex i is
+ * boundaries[boundaryOffsets[i] .. boundaryOffsets[i+1]).
+ */
+struct BinaryFiltration
+{
+    std::vector<std::uint32_t>  dimensions;
+    std::vector<double>         values;
+    std::vector<std::uint64_t>  boundaryOffsets;
+    std::vector<std::uint32_t>  boundaries;
+};
+
+class BinaryFiltrationReader
+{
+public:
+    /**
+     * Reads the header of a binary filtration file. Returns if the operation was successful.
+     */
+    bool ReadHeader(const std::string& filename, BinaryFiltrationHeader& retHeader) const;
+
+    /**
+     * Reads a binary filtration file. Returns if the operation was successful.
+     */
+    bool Read(const std::string& filename, BinaryFiltration& retFiltration) const;
+
+private:
+    bool ReadHeader(std::istream& file, BinaryFiltrationHeader& retHeader) const;
+};
+
+#endif //_BINARY_FILTRATION_H_
@@ -0,0 +1,89 @@
+/**
+ * file: BoundedQueue.h
+ * desc: Blocking first-in-first-out queue with a maximum capacity. Used to connect the
+ *       stages of a pipeline that run on different threads. Only available when compiled
+ *       with _WSSD_THREADS_.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#ifdef _WSSD_THREADS_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template<typename E>
+class BoundedQueue
+{
+// Fields
+private:
+    std::deque<E>           elements;
+    std::size_t             capacity;
+    bool                    closed;
+
+    std::mutex              mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+// Constructor
+public:
+    BoundedQueue(std::size_t capacity)
+    : capacity(capacity)
+    , closed(false)
+    {}
+
+// Functions
+public:
+    /**
+     * Adds an element to the back of the queue. Blocks while the queue is full.
+     */
+    void Push(E&& element)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(elements.size() >= capacity)
+        {
+            notFull.wait(lock);
+        }
+        elements.push_back(std::move(element));
+        notEmpty.notify_one();
+    }
+
+    /**
+     * Removes the front element of the queue. Blocks while the queue is empty. Returns false
+     * once the queue has been closed and all elements have been removed.
+     */
+    bool Pop(E& retElement)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(elements.empty() && !closed)
+        {
+            notEmpty.wait(lock);
+        }
+        if(elements.empty())
+        {
+            return false;
+        }
+        retElement = std::move(elements.front());
+        elements.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Signal that no more elements will be pushed.
+     */
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+#endif //_WSSD_THREADS_
+
+#endif //_BOUNDED_QUEUE_H_
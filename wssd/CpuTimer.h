@@ -1,6 +1,7 @@
 /**
  * file: CpuTimer.h
- * desc: A High Performance timer that measures the time spend on the CPU.
+ * desc: A High Performance timer that measures the time spend on the CPU. Stop returns the elapsed
+ *       wall time in milliseconds.
  *
  * Copyright 2013 Okke Schrijvers.
  */
@@ -12,6 +13,12 @@
 
 #ifdef _WIN32
 
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
 #include <windows.h>
 
 class CpuTimer
@@ -86,8 +93,8 @@ public:
 		{
 			started = false;
 		    gettimeofday(&endTime, NULL);
-			return (endTime.tv_sec - startTime.tv_sec)
-					+ 1e-6 * (endTime.tv_usec - startTime.tv_usec);
+			return 1000.0 * (endTime.tv_sec - startTime.tv_sec)
+					+ 1e-3 * (endTime.tv_usec - startTime.tv_usec);
 		}
 		else
 		{
@@ -0,0 +1,125 @@
+/**
+ * file: DeltaBuckets.h
+ * desc: Stores the prepared tuples of one cardinality grouped by the delta at which they
+ *       are added to the filtration. Each tuple is a fixed number of quadtree nodes in
+ *       ascending order, and all tuples are kept in a single flat array.
+ *
+ *       Tuples are first appended in any order. Sort then groups them by delta with a
+ *       stable counting sort, after which the tuples of a delta are contiguous.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _DELTA_BUCKETS_H_
+#define _DELTA_BUCKETS_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "Assert.h"
+
+// Forward class declarations
+template<typename T, int D>
+class Quadtree;
+
+template<typename T, int D>
+class DeltaBuckets
+{
+// Fields
+private:
+    int                             width;      // Number of nodes per tuple
+    int                             minDelta;
+    std::vector<int>                deltas;     // Delta of each tuple, only used before sorting
+    std::vector<Quadtree<T,D>*>     nodes;      // 'width' nodes per tuple
+    std::vector<std::size_t>        offsets;    // Tuples of delta d are [offsets[d-minDelta], offsets[d-minDelta+1])
+
+// Constructor
+public:
+    DeltaBuckets(int width)
+    : width(width)
+    , minDelta(0)
+    {}
+
+// Functions
+public:
+    /**
+     * Append a tuple of 'width' nodes, sorted in ascending order.
+     */
+    template<typename Iterator>
+    void Add(int delta, Iterator first)
+    {
+        ASSERT(offsets.empty());
+        deltas.push_back(delta);
+        for(int i=0; i<width; ++i, ++first)
+        {
+            nodes.push_back(*first);
+        }
+    }
+
+    /**
+     * Move all tuples of 'rhs' to the end of this container, leaving 'rhs' empty.
+     */
+    void Append(DeltaBuckets<T,D>& rhs)
+    {
+        ASSERT(width == rhs.width && offsets.empty() && rhs.offsets.empty());
+        deltas.insert(deltas.end(), rhs.deltas.begin(), rhs.deltas.end());
+        nodes.insert(nodes.end(), rhs.nodes.begin(), rhs.nodes.end());
+        rhs.clear();
+    }
+
+    /**
+     * Group the tuples by delta. All deltas should lie in [minDelta, maxDelta]. The relative
+     * order of tuples with the same delta is preserved.
+     */
+    void Sort(int minDelta, int maxDelta)
+    {
+        this->minDelta = minDelta;
+
+        // Count the tuples per delta and turn the counts into offsets
+        offsets.assign(maxDelta - minDelta + 2, 0);
+        for(auto it = deltas.cbegin(); it != deltas.cend(); ++it)
+        {
+            ASSERT(minDelta <= *it && *it <= maxDelta);
+            ++offsets[*it - minDelta + 1];
+        }
+        for(std::size_t i=1; i<offsets.size(); ++i)
+        {
+            offsets[i] += offsets[i-1];
+        }
+
+        // Scatter the tuples to their bucket
+        std::vector<std::size_t> next(offsets.begin(), offsets.end()-1);
+        std::vector<Quadtree<T,D>*> sorted(nodes.size());
+        for(std::size_t i=0; i<deltas.size(); ++i)
+        {
+            std::size_t dst = (next[deltas[i] - minDelta]++)*width;
+            std::copy(nodes.begin() + i*width, nodes.begin() + (i+1)*width, sorted.begin() + dst);
+        }
+
+        nodes.swap(sorted);
+        std::vector<int>().swap(deltas);
+    }
+
+    /**
+     * Range of tuple indices with the given delta. Only valid after Sort.
+     */
+    std::size_t Begin(int delta) const { return (delta - minDelta + 1 < int(offsets.size()) ? offsets[delta - minDelta] : Size()); }
+    std::size_t End(int delta)   const { return (delta - minDelta + 1 < int(offsets.size()) ? offsets[delta - minDelta + 1] : Size()); }
+
+    /**
+     * The 'width' nodes of the index'th tuple.
+     */
+    Quadtree<T,D>* const* GetTuple(std::size_t index) const { return &nodes[index*width]; }
+
+    int          GetWidth() const { return width; }
+    std::size_t  Size() const { return nodes.size()/width; }
+
+    void clear()
+    {
+        std::vector<int>().swap(deltas);
+        std::vector<Quadtree<T,D>*>().swap(nodes);
+        std::vector<std::size_t>().swap(offsets);
+    }
+};
+
+#endif //_DELTA_BUCKETS_H_
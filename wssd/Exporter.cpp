@@ -4,11 +4,41 @@
  * Copyright 2013 Okke Schrijvers
  */
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <vector>
 
+#ifdef _WSSD_THREADS_
+#include <thread>
+#endif //_WSSD_THREADS_
+
+#include "BinaryFiltration.h"
 #include "Simplex.h"
 #include "Exporter.h"
+#include "Instantiations.h"
+
+/**
+ * Appends an unsigned integer in decimal, like operator<< does.
+ */
+static void AppendUnsigned(unsigned int value, std::string& retBuffer)
+{
+    char digits[10];
+    int n = 0;
+    do
+    {
+        digits[n++] = char('0' + value%10);
+        value /= 10;
+    }
+    while(value != 0);
+
+    while(n > 0)
+    {
+        retBuffer.push_back(digits[--n]);
+    }
+}
 
 template<typename T, int D>
 void Exporter<T,D>::Export(const Filtration<T,D>& filtration, const std::string& filename) const
@@ -59,4 +89,301 @@ void Exporter<T,D>::Export(const Filtration<T,D>& filtration, const std::string&
     }
 }
 
-template class Exporter<double,2>;
\ No newline at end of file
+template<typename T, int D>
+void Exporter<T,D>::ExportFast(const Filtration<T,D>& filtration, const std::string& filename) const
+{
+    // Number of simplices formatted into one buffer
+    const std::size_t kChunkSize = 1 << 16;
+
+    // Open ASCII file
+    std::ofstream outputFile;
+    outputFile.open(filename);
+
+    if(!outputFile.is_open())
+    {
+        printf("File couldn't be opened. Did not save.\n");
+        return;
+    }
+
+    const std::size_t numSimplices = filtration.simplices.size();
+    const std::size_t numChunks = (numSimplices + kChunkSize - 1)/kChunkSize;
+
+#ifdef _WSSD_THREADS_
+    const std::size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+#else
+    const std::size_t numThreads = 1;
+#endif //_WSSD_THREADS_
+
+    std::vector<std::string> buffers(numThreads);
+
+    // Format up to 'numThreads' chunks at a time, and write them in order
+    for(std::size_t first = 0; first < numChunks; first += numThreads)
+    {
+        const std::size_t count = std::min(numThreads, numChunks - first);
+
+#ifdef _WSSD_THREADS_
+        std::vector<std::thread> threads;
+        for(std::size_t t=1; t<count; ++t)
+        {
+            std::size_t begin = (first + t)*kChunkSize;
+            std::size_t end   = std::min(begin + kChunkSize, numSimplices);
+            threads.push_back(std::thread(&Exporter<T,D>::FormatChunk, this, std::cref(filtration), begin, end, std::ref(buffers[t])));
+        }
+#endif //_WSSD_THREADS_
+
+        FormatChunk(filtration, first*kChunkSize, std::min((first + 1)*kChunkSize, numSimplices), buffers[0]);
+
+#ifdef _WSSD_THREADS_
+        for(auto it = threads.begin(); it != threads.end(); ++it)
+        {
+            it->join();
+        }
+#endif //_WSSD_THREADS_
+
+        for(std::size_t t=0; t<count; ++t)
+        {
+            outputFile.write(buffers[t].data(), buffers[t].size());
+        }
+    }
+
+    outputFile.close();
+}
+
+template<typename T, int D>
+void Exporter<T,D>::FormatChunk(const Filtration<T,D>& filtration, std::size_t begin, std::size_t end, std::string& retBuffer) const
+{
+    retBuffer.clear();
+
+    char value[32];
+    for(std::size_t i=begin; i<end; ++i)
+    {
+        const Simplex<T,D>* simplex = filtration.simplices[i];
+
+        AppendUnsigned((unsigned int)(i+1), retBuffer);
+        retBuffer.push_back(' ');
+
+        // The default stream format of a double is %g with precision 6
+        int length = sprintf_s(value, "%g", simplex->GetFunctionValue()/2.0);
+        retBuffer.append(value, length);
+        retBuffer.push_back(' ');
+
+        AppendUnsigned(simplex->GetK(), retBuffer);
+        if(simplex->GetK() > 0)
+        {
+            for(int j=0; j<simplex->GetK()+1; ++j)
+            {
+                retBuffer.push_back(' ');
+                AppendUnsigned(simplex->GetBoundarySimplex(j)->GetIndex(), retBuffer);
+            }
+        }
+
+        retBuffer.push_back('\n');
+    }
+}
+
+template<typename T, int D>
+void Exporter<T,D>::ExportBinary(const Filtration<T,D>& filtration, const std::string& filename, bool singlePrecision) const
+{
+    // Flush to disk whenever this many bytes are buffered
+    const std::size_t kBufferSize = 1 << 22;
+
+    std::ofstream outputFile;
+    outputFile.open(filename, std::ios::out | std::ios::binary);
+
+    if(!outputFile.is_open())
+    {
+        printf("File couldn't be opened. Did not save.\n");
+        return;
+    }
+
+    // Count the simplices per dimension to fill in the header
+    std::vector<std::uint64_t> counts;
+    for(auto it = filtration.simplices.cbegin(); it != filtration.simplices.cend(); ++it)
+    {
+        if((*it)->GetK() >= int(counts.size()))
+        {
+            counts.resize((*it)->GetK() + 1, 0);
+        }
+        ++counts[(*it)->GetK()];
+    }
+    if(counts.empty())
+    {
+        counts.push_back(0);
+    }
+
+    const std::uint32_t valueBytes   = (singlePrecision ? sizeof(float) : sizeof(double));
+    const std::uint32_t maxDimension = std::uint32_t(counts.size() - 1);
+    const std::uint32_t recordBytes  = 4 + valueBytes + 4*(maxDimension + 1);
+    const std::uint64_t numSimplices = filtration.simplices.size();
+
+    // Write header
+    outputFile.write(kBinaryFiltrationMagic, sizeof(kBinaryFiltrationMagic));
+    outputFile.write((const char*)&kBinaryFiltrationVersion, sizeof(kBinaryFiltrationVersion));
+    outputFile.write((const char*)&valueBytes, sizeof(valueBytes));
+    outputFile.write((const char*)&maxDimension, sizeof(maxDimension));
+    outputFile.write((const char*)&recordBytes, sizeof(recordBytes));
+    outputFile.write((const char*)&numSimplices, sizeof(numSimplices));
+    outputFile.write((const char*)&counts[0], counts.size()*sizeof(std::uint64_t));
+
+    // Write records, filling whole chunks before handing them to the stream
+    const std::size_t recordsPerChunk = std::max<std::size_t>(1, kBufferSize/recordBytes);
+    std::vector<char> buffer(recordsPerChunk*recordBytes);
+    char* record = &buffer[0];
+
+    for(std::size_t i=0; i<filtration.simplices.size(); ++i)
+    {
+        const Simplex<T,D>* simplex = filtration.simplices[i];
+        const std::uint32_t dimension = simplex->GetK();
+
+        memcpy(record, &dimension, 4);
+
+        if(singlePrecision)
+        {
+            float value = float(simplex->GetFunctionValue()/2.0);
+            memcpy(record + 4, &value, sizeof(float));
+        }
+        else
+        {
+            double value = simplex->GetFunctionValue()/2.0;
+            memcpy(record + 4, &value, sizeof(double));
+        }
+
+        char* boundary = record + 4 + valueBytes;
+        for(std::uint32_t j=0; j<=maxDimension; ++j, boundary += 4)
+        {
+            std::uint32_t index = (dimension > 0 && j <= dimension ? simplex->GetBoundarySimplex(j)->GetIndex() : kNoBoundary);
+            memcpy(boundary, &index, 4);
+        }
+
+        record += recordBytes;
+        if(record == &buffer[0] + buffer.size())
+        {
+            outputFile.write(&buffer[0], buffer.size());
+            record = &buffer[0];
+        }
+    }
+    outputFile.write(&buffer[0], record - &buffer[0]);
+
+    outputFile.close();
+}
+
+template<typename T, int D>
+void Exporter<T,D>::ExportPhat(const Filtration<T,D>& filtration, const std::string& filename) const
+{
+    // Flush to disk whenever this many values are buffered
+    const std::size_t kBufferSize = 1 << 19;
+
+    std::ofstream outputFile;
+    outputFile.open(filename, std::ios::out | std::ios::binary);
+
+    if(!outputFile.is_open())
+    {
+        printf("File couldn't be opened. Did not save.\n");
+        return;
+    }
+
+    std::vector<std::int64_t> buffer;
+    buffer.reserve(kBufferSize + D + 4);
+
+    buffer.push_back(filtration.simplices.size());
+    for(auto it = filtration.simplices.cbegin(); it != filtration.simplices.cend(); ++it)
+    {
+        buffer.push_back((*it)->GetK());
+        buffer.push_back((*it)->GetK() > 0 ? (*it)->GetK() + 1 : 0);
+        GetSortedBoundary(*it, buffer);
+
+        if(buffer.size() >= kBufferSize)
+        {
+            outputFile.write((const char*)&buffer[0], buffer.size()*sizeof(std::int64_t));
+            buffer.clear();
+        }
+    }
+    outputFile.write((const char*)&buffer[0], buffer.size()*sizeof(std::int64_t));
+
+    outputFile.close();
+}
+
+template<typename T, int D>
+void Exporter<T,D>::ExportDipha(const Filtration<T,D>& filtration, const std::string& filename) const
+{
+    const std::int64_t kDiphaMagic                  = 8067171840;
+    const std::int64_t kWeightedBoundaryMatrix      = 0;
+    const std::int64_t kBooleanCoefficients         = 0;
+
+    std::ofstream outputFile;
+    outputFile.open(filename, std::ios::out | std::ios::binary);
+
+    if(!outputFile.is_open())
+    {
+        printf("File couldn't be opened. Did not save.\n");
+        return;
+    }
+
+    const std::size_t numCells = filtration.simplices.size();
+
+    // The header needs the number of entries, and the arrays are stored one after the other,
+    // so build dimensions and offsets first.
+    std::vector<std::int64_t> dims(numCells);
+    std::vector<std::int64_t> offsets(numCells);
+    std::int64_t numEntries = 0;
+    std::int64_t maxDim = 0;
+    for(std::size_t i=0; i<numCells; ++i)
+    {
+        const int k = filtration.simplices[i]->GetK();
+        dims[i]    = k;
+        offsets[i] = numEntries;
+        numEntries += (k > 0 ? k + 1 : 0);
+        maxDim = std::max<std::int64_t>(maxDim, k);
+    }
+
+    std::int64_t header[6] = { kDiphaMagic, kWeightedBoundaryMatrix, kBooleanCoefficients, std::int64_t(numCells), numEntries, maxDim };
+    outputFile.write((const char*)header, sizeof(header));
+    if(numCells > 0)
+    {
+        outputFile.write((const char*)&dims[0], numCells*sizeof(std::int64_t));
+    }
+
+    std::vector<double> values(numCells);
+    for(std::size_t i=0; i<numCells; ++i)
+    {
+        values[i] = filtration.simplices[i]->GetFunctionValue()/2.0;
+    }
+    if(numCells > 0)
+    {
+        outputFile.write((const char*)&values[0], numCells*sizeof(double));
+        outputFile.write((const char*)&offsets[0], numCells*sizeof(std::int64_t));
+    }
+
+    // Reuse 'dims' as the buffer for the entries
+    std::vector<std::int64_t>& entries = dims;
+    entries.clear();
+    for(std::size_t i=0; i<numCells; ++i)
+    {
+        GetSortedBoundary(filtration.simplices[i], entries);
+    }
+    if(!entries.empty())
+    {
+        outputFile.write((const char*)&entries[0], entries.size()*sizeof(std::int64_t));
+    }
+
+    outputFile.close();
+}
+
+template<typename T, int D>
+void Exporter<T,D>::GetSortedBoundary(const Simplex<T,D>* simplex, std::vector<std::int64_t>& retBoundary) const
+{
+    if(simplex->GetK() == 0)
+    {
+        return;
+    }
+
+    std::size_t first = retBoundary.size();
+    for(int j=0; j<simplex->GetK()+1; ++j)
+    {
+        retBoundary.push_back(simplex->GetBoundarySimplex(j)->GetIndex());
+    }
+    std::sort(retBoundary.begin() + first, retBoundary.end());
+}
+
+#define INSTANTIATE_EXPORTER(T,D) template class Exporter<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_EXPORTER)
\ No newline at end of file
@@ -1,6 +1,7 @@
 /**
  * file: Exporter.h
- * desc: Exports a filtration to a text file.
+ * desc: Exports a filtration to a text or binary file, or as a boundary matrix for
+ *       PHAT and DIPHA.
  *
  * Copyright 2013 Okke Schrijvers
  */
@@ -8,7 +9,9 @@
 #ifndef __EXPORTER_H__
 #define __EXPORTER_H__
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "Filtration.h"
 
@@ -27,6 +30,49 @@ public:
      */
     void Export(const Filtration<T,D>& filtration, const std::string& filename) const;
 
+    /**
+     * Saves to the same ASCII format as Export, producing an identical file. Chunks of simplices
+     * are formatted into separate buffers, in parallel when compiled with _WSSD_THREADS_, and
+     * the buffers are written in order without flushing per line.
+     */
+    void ExportFast(const Filtration<T,D>& filtration, const std::string& filename) const;
+
+    /**
+     * Saves to the binary format described in BinaryFiltration.h, which can be loaded with
+     * BinaryFiltrationReader. Records have a fixed width and are written through a large buffer.
+     * If 'singlePrecision' is set, function values are stored as floats.
+     */
+    void ExportBinary(const Filtration<T,D>& filtration, const std::string& filename, bool singlePrecision = false) const;
+
+    /**
+     * Saves the boundary matrix in PHAT's binary format:
+     *
+     *   int64 #columns, and per column: int64 dimension, int64 #entries, int64 row0 ... rowk
+     *
+     * Columns are in filtration order and rows are sorted ascending, as PHAT expects.
+     */
+    void ExportPhat(const Filtration<T,D>& filtration, const std::string& filename) const;
+
+    /**
+     * Saves the boundary matrix in DIPHA's weighted boundary matrix format, with the alpha
+     * value of each simplex as its weight:
+     *
+     *   int64 magic, int64 file type, int64 boundary type (0: Z2), int64 #cells N, int64 #entries M,
+     *   int64 max dimension, int64 dims[N], double values[N], int64 offsets[N], int64 entries[M]
+     */
+    void ExportDipha(const Filtration<T,D>& filtration, const std::string& filename) const;
+
+private:
+    /**
+     * Appends the lines of simplices [begin, end) in the format of Export to 'retBuffer'.
+     */
+    void FormatChunk(const Filtration<T,D>& filtration, std::size_t begin, std::size_t end, std::string& retBuffer) const;
+
+    /**
+     * Appends the indices of the boundary simplices of 'simplex' in ascending order.
+     */
+    void GetSortedBoundary(const Simplex<T,D>* simplex, std::vector<std::int64_t>& retBoundary) const;
+
 };
 
 
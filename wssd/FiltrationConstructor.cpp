@@ -10,10 +10,16 @@
 
 #include "Miniball.hpp"
 
+#include "BoundedQueue.h"
+#include "Metrics.h"
 #include "Quadtree.h"
 #include "Simplex.h"
+#include "Trace.h"
 #include "Filtration.h"
+#include "WspdConstructor.h"
+#include "WssdConstructor.h"
 #include "FiltrationConstructor.h"
+#include "Instantiations.h"
 
 
 
@@ -27,53 +33,211 @@ FiltrationConstructor<T,D>::FiltrationConstructor(double eps, int minDelta, int
 , highestDelta(0)
 , totalVertices(0)
 , collapsedVertices(0)
-{}
+, probe(std::vector<Quadtree<T,D>*>())
+, starEpoch(0)
+, metrics(NULL)
+, tracer(NULL)
+{
+    for(int k=1; k<=D; ++k)
+    {
+        tuples.push_back(DeltaBuckets<T,D>(k+1));
+    }
+}
 
 template<typename T, int D>
 void FiltrationConstructor<T,D>::ConstructFiltration(WSSD<T,D>& wssd, Filtration<T,D>& retFiltration)
 {
     totalVertices = 0;
     collapsedVertices = 0;
+    ClearVertices();
+    deltaCounters.clear();
 
 
     // Create the initial vertices and simplices
     Quadtree<T,D>* root = GetHighestAncestor(wssd.GetKWssd<1>()[0][0], std::numeric_limits<double>::infinity());
-    AddAllVertices(root, GetMaxQuadtreeCellDiam(GetTheta(minDelta)), retFiltration);
+    {
+        ScopedStage stage(metrics, "vertices");
+        AddAllVertices(root, GetMaxQuadtreeCellDiam(GetTheta(minDelta)), retFiltration);
+        if(metrics) metrics->AddCount("vertices", totalVertices);
+    }
+
+    {
+        ScopedStage stage(metrics, "prepare_tuples");
+        std::cout << "Preparing WSSD" << std:: endl;
+        {
+            ScopedStage findStage(metrics, "find_time_to_add_1");
+            PrepareTuples<1>(wssd);
+        }
+        std::cout << "After 1-WSSD." << std:: endl;
+        {
+            ScopedStage findStage(metrics, "find_time_to_add_2");
+            PrepareTuples<2>(wssd);
+        }
+        std::cout << "After 2-WSSD." << std:: endl;
+        maxDelta = highestDelta;
+        wssd.clear();
+        if(metrics)
+        {
+            metrics->AddCount("tuples_1", tuples[0].Size());
+            metrics->AddCount("tuples_2", tuples[1].Size());
+        }
+    }
+
+    AddTuplesToFiltration(retFiltration);
+}
+
+template<typename T, int D>
+void FiltrationConstructor<T,D>::ConstructFiltration(Quadtree<T,D>* root, WspdConstructor<T,D>& wspdConstructor,
+    WssdConstructor<T,D,2>& wssdConstructor, Filtration<T,D>& retFiltration)
+{
+    totalVertices = 0;
+    collapsedVertices = 0;
+    ClearVertices();
+    deltaCounters.clear();
+
+    // Create the initial vertices, this needs the bounding boxes of the quadtree
+    {
+        ScopedStage stage(metrics, "vertices");
+        root->UpdateBoundingBoxes();
+        AddAllVertices(root, GetMaxQuadtreeCellDiam(GetTheta(minDelta)), retFiltration);
+        if(metrics) metrics->AddCount("vertices", totalVertices);
+    }
+
+    if(metrics) metrics->BeginStage("wspd_wssd_prepare_tuples");
+    std::cout << "Preparing WSSD in batches" << std:: endl;
+
+#ifdef _WSSD_THREADS_
+    // The WSPD traversal feeds the workers that build and sort the 2-tuples
+    int numWorkers = std::max(1, int(std::thread::hardware_concurrency()) - 1);
+    BoundedQueue<KWSSD(T,D,1)> batches(2*numWorkers);
+
+    std::vector<std::thread> workers;
+    for(int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            TraceBuffer* traceBuffer = (tracer != NULL ? tracer->GetThreadBuffer() : NULL);
+
+            KWSSD(T,D,1) pairs;
+            while(batches.Pop(pairs))
+            {
+                ScopedSpan span(tracer, traceBuffer, "prepare_batch", pairs.size());
+                PrepareBatch(pairs, root, wssdConstructor);
+            }
+        }));
+    }
+
+    // Pushing blocks while the workers are behind
+    TraceBuffer* traceBuffer = (tracer != NULL ? tracer->GetThreadBuffer() : NULL);
+    wspdConstructor.ConstructWspd(root, kFusedBatchSize, [&](KWSSD(T,D,1)& pairs)
+    {
+        ScopedSpan span(tracer, traceBuffer, "push_batch", pairs.size());
+        batches.Push(std::move(pairs));
+        pairs.clear();
+    });
+
+    batches.Close();
+    for (auto& th : workers) th.join();
+#else // ~_WSSD_THREADS_
+    TraceBuffer* traceBuffer = (tracer != NULL ? tracer->GetThreadBuffer() : NULL);
+    wspdConstructor.ConstructWspd(root, kFusedBatchSize, [&](KWSSD(T,D,1)& pairs)
+    {
+        ScopedSpan span(tracer, traceBuffer, "prepare_batch", pairs.size());
+        PrepareBatch(pairs, root, wssdConstructor);
+        pairs.clear();
+    });
+#endif //_WSSD_THREADS_
 
-    std::cout << "Preparing WSSD" << std:: endl;
-    PrepareTuples<1>(wssd);
-    std::cout << "After 1-WSSD." << std:: endl;
-    PrepareTuples<2>(wssd);
     std::cout << "After 2-WSSD." << std:: endl;
     maxDelta = highestDelta;
-    wssd.clear();
+    if(metrics)
+    {
+        metrics->AddCount("tuples_1", tuples[0].Size());
+        metrics->AddCount("tuples_2", tuples[1].Size());
+    }
+    if(metrics) metrics->EndStage();
 
-    //for(int i = minDelta; i<=maxDelta; ++i)
-    //{
-    //    std::cout << tuples[i].size() << std::endl;
-    //}
+    AddTuplesToFiltration(retFiltration);
+}
+
+template<typename T, int D>
+void FiltrationConstructor<T,D>::AddTuplesToFiltration(Filtration<T,D>& retFiltration)
+{
+    ScopedStage filtrationStage(metrics, "filtration");
+
+    // Group the tuples by delta
+    for(auto it = tuples.begin(); it != tuples.end(); ++it)
+    {
+        it->Sort(minDelta, maxDelta);
+    }
 
     // Update the simplices and add new ones
     double theta = GetTheta(minDelta);
     for(int i = minDelta; i<=maxDelta; ++i, theta*=(1.0+epsilon))
     {
-        UpdateToNewTheta(theta, retFiltration);
+        char stageName[32];
+        sprintf_s(stageName, "delta_%d", i);
+        ScopedStage deltaStage(metrics, stageName);
 
-        std::vector<std::set<Quadtree<T,D>*>>& nodes = tuples[i];
-        for(auto it = nodes.begin(); it != nodes.end(); ++it)
+        counters.clear();
         {
-            AddSimplexToFiltration(*it, theta, retFiltration);
+            ScopedStage collapseStage(metrics, "collapse");
+            UpdateToNewTheta(theta, retFiltration);
         }
 
-        nodes.clear();
+        // Lower dimensional simplices first, their cofaces need them as boundary.
+        {
+            ScopedStage addStage(metrics, "add_simplices");
+            for(auto it = tuples.cbegin(); it != tuples.cend(); ++it)
+            {
+                for(std::size_t j = it->Begin(i); j < it->End(i); ++j)
+                {
+                    AddSimplexToFiltration(it->GetTuple(j), it->GetWidth(), theta, retFiltration);
+                }
+            }
+        }
 
         std::cout << "Handled iteration " << i << " size of filtration: " << retFiltration.simplices.size() << std::endl;
         std::cout << "Collapsed vertices: " << collapsedVertices << "/" << totalVertices << std::endl;
 
+        // Together with the work of preparing the tuples of this delta
+        FiltrationCounters& iterationCounters = GetCountersOfDelta(deltaCounters, minDelta, i);
+        iterationCounters.Add(counters);
+
+        if(metrics)
+        {
+            metrics->AddCount("simplices", retFiltration.simplices.size());
+            metrics->AddCount("collapsed_vertices", collapsedVertices);
+            for(int c=0; c<kNumFiltrationCounters; ++c)
+            {
+                metrics->AddCount(filtrationCounterNames[c], iterationCounters[FiltrationCounter(c)]);
+            }
+        }
+
         if( collapsedVertices + 1 == totalVertices)
             break;
 
-        
+
+    }
+
+    if(metrics) metrics->AddCount("simplices", retFiltration.simplices.size());
+
+    // Totals of all deltas, including the tuples discarded beyond the last one
+    FiltrationCounters total;
+    for(auto it = deltaCounters.cbegin(); it != deltaCounters.cend(); ++it)
+    {
+        total.Add(*it);
+    }
+    std::cout << "Hot-path counts:";
+    for(int c=0; c<kNumFiltrationCounters; ++c)
+    {
+        std::cout << " " << filtrationCounterNames[c] << "=" << total[FiltrationCounter(c)];
+    }
+    std::cout << std::endl;
+
+    for(auto it = tuples.begin(); it != tuples.end(); ++it)
+    {
+        it->clear();
     }
 }
 
@@ -92,18 +256,19 @@ void FiltrationConstructor<T,D>::AddAllVertices(Quadtree<T,D>* root, double maxN
     }
     else
     {
-        root->SetRepresentative(root);
-        AddVertexToFiltration(root, retFiltration);
+        root->SetRepresentative(AddVertexToFiltration(root, retFiltration));
     }
 }
 
 template<typename T, int D>
 template<int K>
-int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>& tuple, std::set<Quadtree<T, D>*>& retNodes)
+int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>& tuple, std::set<Quadtree<T, D>*>& retNodes,
+    FiltrationCounters& retCounters, int& retCountedDelta)
 {
 	int delta = minDelta;
 	double theta = GetTheta(delta);
-	while (tuple.GetMaxDiam() > GetMaxQuadtreeCellDiam(theta))
+	double maxDiam = tuple.GetMaxDiam();
+	while (maxDiam > GetMaxQuadtreeCellDiam(theta))
 	{
 		delta++;
 		theta *= (1.0 + epsilon);
@@ -113,14 +278,17 @@ int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>
 	retNodes.clear();
 	for (int j = 0; j < K + 1; ++j)
 	{
-		retNodes.insert(GetHighestAncestor(tuple[j], GetMaxQuadtreeCellDiam(theta)));
+		retNodes.insert(GetHighestAncestor(tuple[j], GetMaxQuadtreeCellDiam(theta), &retCounters));
 	}
 	if (retNodes.size() < K + 1)
 	{
+		retCounters[kDiscardedTuples]++;
+		retCountedDelta = delta;
 		return -1;
 	}
 
 	double retNodesDiam = GetDiam(retNodes);
+	retCounters[kMiniballCalls]++;
 
 	while (retNodesDiam > GetMaxTupleDiam(theta))
 	{
@@ -134,6 +302,7 @@ int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>
 		{
 			if (retNodesDiam <= GetMaxTupleDiam(theta))
 			{
+				retCountedDelta = delta;
 				return delta;
 			}
 			delta++;
@@ -146,7 +315,7 @@ int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>
 
 		while (it != retNodes.end())
 		{
-			quadtree = GetHighestAncestor(*it, GetMaxQuadtreeCellDiam(theta));
+			quadtree = GetHighestAncestor(*it, GetMaxQuadtreeCellDiam(theta), &retCounters);
 			if ((*it) != quadtree)
 			{
 				Quadtree<T, D>* removeMe = *it;
@@ -164,12 +333,16 @@ int FiltrationConstructor<T, D>::FindTimeToAdd(const WellSeparatedTuple<T, D, K>
 
 		if (retNodes.size() < K + 1)
 		{
+			retCounters[kDiscardedTuples]++;
+			retCountedDelta = delta;
 			return -1;
 		}
 
 		retNodesDiam = GetDiam(retNodes);
+		retCounters[kMiniballCalls]++;
 	}
 
+	retCountedDelta = delta;
 	return delta;
 }
 
@@ -178,22 +351,34 @@ template<int K>
 void FiltrationConstructor<T, D>::AddToMap(const WellSeparatedTuple<T, D, K>& tuple)
 {
 	std::set<Quadtree<T, D>*> nodes;
-	int delta = FindTimeToAdd(tuple, nodes);
+
+	FiltrationCounters tupleCounters;
+	int countedDelta;
+	int delta = FindTimeToAdd(tuple, nodes, tupleCounters, countedDelta);
+
+#ifdef _WSSD_THREADS_
+	hdMutex.lock();
+#endif //_WSSD_THREADS_
+
+	// Counted at the delta the tuple ends up at, or is discarded at
+	GetCountersOfDelta(deltaCounters, minDelta, countedDelta).Add(tupleCounters);
 	if (delta > -1)
 	{
+		highestDelta = std::max(highestDelta, delta);
+	}
 
 #ifdef _WSSD_THREADS_
-		hdMutex.lock();
+	hdMutex.unlock();
 #endif //_WSSD_THREADS_
 
-		highestDelta = std::max(highestDelta, delta);
+	if (delta > -1)
+	{
 
 #ifdef _WSSD_THREADS_
-        hdMutex.unlock();
         tuplesMutex.lock();
 #endif //_WSSD_THREADS_
 
-		tuples[delta].push_back(nodes);
+		tuples[K-1].Add(delta, nodes.begin());
 
 #ifdef _WSSD_THREADS_
         tuplesMutex.unlock();
@@ -203,29 +388,83 @@ void FiltrationConstructor<T, D>::AddToMap(const WellSeparatedTuple<T, D, K>& tu
 
 template<typename T, int D>
 template<int K>
-void FiltrationConstructor<T,D>::PrepareTuples(WSSD<T,D>& wssd)
+void FiltrationConstructor<T,D>::AddBatchToMap(const KWSSD(T,D,K)& wssd, TupleBuckets& retTuples, int& retHighestDelta,
+    std::vector<FiltrationCounters>& retCounters)
 {
-#ifdef _WSSD_THREADS_
-	std::vector<std::thread> threads;
-#endif //_WSSD_THREADS_
+    std::set<Quadtree<T,D>*> nodes;
+    for(auto it = wssd.cbegin(); it != wssd.cend(); ++it)
+    {
+        FiltrationCounters tupleCounters;
+        int countedDelta;
+        int delta = FindTimeToAdd(*it, nodes, tupleCounters, countedDelta);
+        GetCountersOfDelta(retCounters, minDelta, countedDelta).Add(tupleCounters);
+        if(delta > -1)
+        {
+            retHighestDelta = std::max(retHighestDelta, delta);
+            retTuples[K-1].Add(delta, nodes.begin());
+        }
+    }
+}
 
-	int i = 0;
+template<typename T, int D>
+void FiltrationConstructor<T,D>::PrepareBatch(const KWSSD(T,D,1)& pairs, Quadtree<T,D>* root, WssdConstructor<T,D,2>& wssdConstructor)
+{
+    // The 2-tuples point into 'pairs', so they are handled before the batch is discarded
+    KWSSD(T,D,2) triples;
+    wssdConstructor.ConstructWssd(pairs, root, triples);
+
+    TupleBuckets batchTuples;
+    batchTuples.push_back(DeltaBuckets<T,D>(2));
+    batchTuples.push_back(DeltaBuckets<T,D>(3));
+    int batchHighestDelta = 0;
+    std::vector<FiltrationCounters> batchCounters;
+    AddBatchToMap<1>(pairs, batchTuples, batchHighestDelta, batchCounters);
+    AddBatchToMap<2>(triples, batchTuples, batchHighestDelta, batchCounters);
 
-    // Add simplices for this level
-    for(KWSSD(T,D,K)::iterator it = wssd.GetKWssd<K>().begin(); it != wssd.GetKWssd<K>().end(); ++it, ++i)
-    {
 #ifdef _WSSD_THREADS_
-        threads.push_back(std::thread(std::bind(&FiltrationConstructor<T, D>::AddToMap<K>, std::ref(*this), std::ref(*it))));
-#else // ~_WSSD_THREADS_
-        AddToMap(*it);
+    std::lock_guard<std::mutex> hdLock(hdMutex);
+    std::lock_guard<std::mutex> tuplesLock(tuplesMutex);
 #endif //_WSSD_THREADS_
+
+    highestDelta = std::max(highestDelta, batchHighestDelta);
+    AddCountersOfDeltas(deltaCounters, batchCounters);
+    for(std::size_t k = 0; k < batchTuples.size(); ++k)
+    {
+        tuples[k].Append(batchTuples[k]);
     }
+}
+
+template<typename T, int D>
+template<int K>
+void FiltrationConstructor<T,D>::PrepareTuples(WSSD<T,D>& wssd)
+{
+    KWSSD(T,D,K)& kWssd = wssd.GetKWssd<K>();
 
 #ifdef _WSSD_THREADS_
+    // Every thread handles a consecutive chunk of the tuples, traced as a single span
+    const int numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+	std::vector<std::thread> threads;
+    for(int t = 0; t < numThreads; ++t)
+    {
+        const std::size_t begin = kWssd.size()*t/numThreads;
+        const std::size_t end = kWssd.size()*(t+1)/numThreads;
+        threads.push_back(std::thread([this, &kWssd, begin, end]()
+        {
+            ScopedSpan span(tracer, "find_time_to_add", end - begin);
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                AddToMap(kWssd[i]);
+            }
+        }));
+    }
 	for (auto& th : threads) th.join();
+#else // ~_WSSD_THREADS_
+    // Add simplices for this level
+    for(KWSSD(T,D,K)::iterator it = kWssd.begin(); it != kWssd.end(); ++it)
+    {
+        AddToMap(*it);
+    }
 #endif //_WSSD_THREADS_
-
-    wssd.GetKWssd<K>().clear();
 }
 
 
@@ -235,41 +474,41 @@ void FiltrationConstructor<T,D>::PrepareTuples(WSSD<T,D>& wssd)
 template<typename T, int D>
 void FiltrationConstructor<T,D>::UpdateToNewTheta(double theta, Filtration<T,D>& retFiltration)
 {
-    // Iterate over all simplices in the filtration
-    for(unsigned int i=0; i<retFiltration.simplices.size(); ++i)
-    {
-        Simplex<T,D>* simplex = retFiltration.simplices[i];
+    double maxCellDiam = GetMaxQuadtreeCellDiam(theta);
 
-        // If it's a vertex, we might need to collapse it to another one
-        if(simplex->GetK() == 0 && !simplex->IsCollapsed())
-        {
-            // Get largest ancestor that is small enough
-            Quadtree<T,D>* node = GetHighestAncestor((*simplex)[0], GetMaxQuadtreeCellDiam(theta));
+    // Iterate over the vertices that have not been collapsed, and keep the ones that remain
+    std::size_t numLive = 0;
+    for(std::size_t i=0; i<liveVertices.size(); ++i)
+    {
+        unsigned int v = liveVertices[i];
 
-            // If we changed representatives
-            if(node->GetRepresentative() != (*simplex)[0]->GetRepresentative())
-            {
-                Simplex<T,D>* temp = new Simplex<T,D>(node->GetRepresentative());
-                auto foundSimplex = simplices.find(temp);
-                delete temp;
-                
-                Simplex<T,D>* u = retFiltration.simplices[(*foundSimplex)->GetIndex()];
-                Simplex<T,D>* v = simplex;
+        // Get largest ancestor that is small enough. It only moves up as theta grows.
+        Quadtree<T,D>* node = GetHighestAncestor(vertexAncestors[v], maxCellDiam, &counters);
+        vertexAncestors[v] = node;
 
-                ASSERT(u->GetVertices()[0] == u->GetVertices()[0]->GetRepresentative());
-                ASSERT(v->GetVertices()[0] == v->GetVertices()[0]->GetRepresentative());
+        // If we changed representatives, collapse v to the vertex that now represents it
+        unsigned int u = vertexSets.Find(node->GetRepresentative());
+        if(u != v)
+        {
+            ASSERT(vertexSets.Find(v) == v);
+            ASSERT(!vertexSimplices[u]->IsCollapsed());
 
-                Collapse(u, v, theta, retFiltration);
-            }
+            Collapse(vertexSimplices[u], vertexSimplices[v], theta, retFiltration);
+            vertexSets.Union(v, u);
+        }
+        else
+        {
+            liveVertices[numLive++] = v;
         }
     }
+    liveVertices.resize(numLive);
 }
 
 
 
 
 template<typename T, int D>
-void FiltrationConstructor<T,D>::AddVertexToFiltration(Quadtree<T,D>* node, Filtration<T,D>& retFiltration)
+unsigned int FiltrationConstructor<T,D>::AddVertexToFiltration(Quadtree<T,D>* node, Filtration<T,D>& retFiltration)
 {
     // Create the vertex and check if we've already seen it.
     Simplex<T,D>* vertex = new Simplex<T,D>(node, retFiltration.simplices.size(), 0.0);
@@ -278,20 +517,42 @@ void FiltrationConstructor<T,D>::AddVertexToFiltration(Quadtree<T,D>* node, Filt
     retFiltration.simplices.push_back(vertex);
     simplices.insert(vertex);
 
+    // Start tracking the vertex for collapses
+    unsigned int id = vertexSets.Add();
+    vertexSimplices.push_back(vertex);
+    vertexAncestors.push_back(node);
+    liveVertices.push_back(id);
+
     totalVertices++;
+    return id;
+}
+
+template<typename T, int D>
+void FiltrationConstructor<T,D>::ClearVertices()
+{
+    vertexSets.clear();
+    vertexSimplices.clear();
+    vertexAncestors.clear();
+    liveVertices.clear();
 }
 
 
 template<typename T, int D>
-void FiltrationConstructor<T,D>::AddSimplexToFiltration(const std::set<Quadtree<T,D>*>& nodes, double theta, Filtration<T,D>& retFiltration)
+void FiltrationConstructor<T,D>::AddSimplexToFiltration(Quadtree<T,D>* const* nodes, int numNodes, double theta, Filtration<T,D>& retFiltration)
 {
     // Get the representatives of the simplex
-    std::vector<Quadtree<T,D>*> reps(nodes.size());
-    GetRepresentatives(nodes, reps);
-
-    Simplex<T,D>* simplex = new Simplex<T,D>(reps, retFiltration.simplices.size(), theta);
-    if(simplices.find(simplex) == simplices.end())
+    std::vector<Quadtree<T,D>*>& reps = repScratch;
+    reps.resize(numNodes);
+    GetRepresentatives(nodes, numNodes, reps);
+
+    // Only allocate the simplex if it is new
+    probe.Assign(reps);
+    counters[kSetLookups]++;
+    if(simplices.find(&probe) == simplices.end())
     {
+        counters[kSetMisses]++;
+        Simplex<T,D>* simplex = new Simplex<T,D>(reps, retFiltration.simplices.size(), theta);
+
         // Build the boundary
         std::vector<Simplex<T,D>*>& boundary = simplex->GetBoundary();
         {
@@ -299,11 +560,11 @@ void FiltrationConstructor<T,D>::AddSimplexToFiltration(const std::set<Quadtree<
             for(auto it = reps.begin(); it != reps.end(); ++it)
             {
                 // Creates the face of all nodes except for it
-                Simplex<T,D>* s = new Simplex<T,D>(*simplex, NULL, *it);
+                probe.Assign(*simplex, NULL, *it);
 
-                auto foundSimplex = simplices.find(s);
+                counters[kSetLookups]++;
+                auto foundSimplex = simplices.find(&probe);
                 boundary.push_back(retFiltration.simplices[(*foundSimplex)->GetIndex()]);
-                delete s;
             }
         }
         
@@ -317,19 +578,18 @@ void FiltrationConstructor<T,D>::AddSimplexToFiltration(const std::set<Quadtree<
             (*it)->AddParent(simplex);
         }
     }
-    else
-    {
-        // Simplex already existed, clean up
-        delete simplex;
-    }
 }
 
 template<typename T, int D>
 void FiltrationConstructor<T,D>::Collapse(Simplex<T,D>* u, Simplex<T,D>* v, double theta, Filtration<T,D>& retFiltration)
 {
     // Get the star of v
-    std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator> star;
-    GetStarClosure(v, retFiltration, star);
+    std::vector<Simplex<T,D>*>& star = starScratch;
+    GetStarClosure(v, star);
+
+    counters[kCollapses]++;
+    counters[kStarSimplices] += star.size();
+    counters[kMaxStarSize] = std::max<unsigned long long>(counters[kMaxStarSize], star.size());
 
     Simplex<T,D>* starSimplex;
     Simplex<T,D>* s;
@@ -339,9 +599,15 @@ void FiltrationConstructor<T,D>::Collapse(Simplex<T,D>* u, Simplex<T,D>* v, doub
     {
         starSimplex = *it;
 
-        s = new Simplex<T,D>(*starSimplex, u->GetVertices()[0], NULL, retFiltration.simplices.size(), theta);
-        if( simplices.find(s) == simplices.end() && s->GetK() < D+1)
+        // Only allocate the simplex if it is new
+        probe.Assign(*starSimplex, u->GetVertices()[0], NULL);
+        counters[kSetLookups]++;
+        bool found = (simplices.find(&probe) != simplices.end());
+        counters[kSetMisses] += !found;
+        if( !found && probe.GetK() < D+1)
         {
+            s = new Simplex<T,D>(*starSimplex, u->GetVertices()[0], NULL, retFiltration.simplices.size(), theta);
+
             // Now do the boundary
             std::vector<Simplex<T,D>*>& boundary = s->GetBoundary();
             if(starSimplex->GetK() == 0)
@@ -353,10 +619,10 @@ void FiltrationConstructor<T,D>::Collapse(Simplex<T,D>* u, Simplex<T,D>* v, doub
             {
                 for(auto it2 = s->GetVertices().cbegin(); it2 != s->GetVertices().cend(); ++it2)
                 {
-                    Simplex<T,D>* s2 = new Simplex<T,D>(*s, NULL, *it2);
-                    auto foundSimplex = simplices.find(s2);
+                    probe.Assign(*s, NULL, *it2);
+                    counters[kSetLookups]++;
+                    auto foundSimplex = simplices.find(&probe);
                     boundary.push_back(retFiltration.simplices[(*foundSimplex)->GetIndex()]);
-                    delete s2;
                 }
             }
 
@@ -371,12 +637,6 @@ void FiltrationConstructor<T,D>::Collapse(Simplex<T,D>* u, Simplex<T,D>* v, doub
             retFiltration.simplices.push_back(s);
             simplices.insert(s);
         }
-        else
-        {
-            // We already had s in the filtration
-            delete s;
-            s = NULL;
-        }
     }
 
     for(auto it = star.begin(); it != star.end(); ++it)
@@ -398,26 +658,38 @@ void FiltrationConstructor<T,D>::Collapse(Simplex<T,D>* u, Simplex<T,D>* v, doub
 
 
 template<typename T, int D>
-void FiltrationConstructor<T,D>::GetStarClosure(Simplex<T,D>* simplex,  const Filtration<T,D>& filtration, std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator>& retStarClosure) const
+void FiltrationConstructor<T,D>::GetStarClosure(Simplex<T,D>* simplex, std::vector<Simplex<T,D>*>& retStarClosure)
 {
-    std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator> star;
-    simplex->GetStar(star);
-
-    // Copy the container
-    retStarClosure = star;
-    
-    // Get the closure
-    for(auto it = star.cbegin(); it != star.cend(); ++it)
+    // Every traversal gets a new epoch, so the visited marks never have to be reset
+    ++starEpoch;
+
+    retStarClosure.clear();
+    simplex->GetStar(starEpoch, retStarClosure, starStack);
+
+    // Get the closure. The face of a star simplex opposite of 'simplex' is in its boundary.
+    std::size_t starSize = retStarClosure.size();
+    for(std::size_t i = 0; i < starSize; ++i)
     {
-        if((*it)->GetK()>0)
+        Simplex<T,D>* starSimplex = retStarClosure[i];
+        if(starSimplex->GetK()>0)
         {
-            Simplex<T,D>* s = new Simplex<T,D>(**it, NULL, (*simplex)[0]);
-            auto foundSimplex = simplices.find(s);
-            retStarClosure.insert(filtration.simplices[(*foundSimplex)->GetIndex()]);
-
-            delete s;
+            for(int j = 0; j < starSimplex->GetK()+1; ++j)
+            {
+                Simplex<T,D>* face = starSimplex->GetBoundarySimplex(j);
+                if(!face->Contains((*simplex)[0]))
+                {
+                    if(face->Visit(starEpoch))
+                    {
+                        retStarClosure.push_back(face);
+                    }
+                    break;
+                }
+            }
         }
     }
+
+    // Handle the simplices in the same order as a set would
+    std::sort(retStarClosure.begin(), retStarClosure.end(), typename Simplex<T,D>::Comparator());
 }
 
 template<typename T, int D>
@@ -480,25 +752,30 @@ bool FiltrationConstructor<T,D>::ShouldAdd(const std::set<Quadtree<T,D>*>& nodes
 
 
 template<typename T, int D>
-Quadtree<T,D>* FiltrationConstructor<T,D>::GetHighestAncestor(Quadtree<T,D>* node, const double& maxDiam) const
+Quadtree<T,D>* FiltrationConstructor<T,D>::GetHighestAncestor(Quadtree<T,D>* node, const double& maxDiam, FiltrationCounters* retCounters) const
 {
+    unsigned long long steps = 0;
     while( node->GetParent() && node->GetParent()->GetAabb().GetDiameter() <= maxDiam )
     {
         node = node->GetParent();
+        ++steps;
     }
 
+    if(retCounters)
+    {
+        (*retCounters)[kAncestorSteps] += steps;
+    }
     return node;
 }
 
 template<typename T, int D>
-void FiltrationConstructor<T,D>::GetRepresentatives(const std::set<Quadtree<T,D>*>& nodes, std::vector<Quadtree<T,D>*>& representatives) const
+void FiltrationConstructor<T,D>::GetRepresentatives(Quadtree<T,D>* const* nodes, int numNodes, std::vector<Quadtree<T,D>*>& representatives)
 {
-    int i=0;
-    for(auto it = nodes.begin(); it!=nodes.end(); ++it)
+    for(int i=0; i<numNodes; ++i)
     {
-        representatives[i] = (*it)->GetRepresentative();
-        ++i;
+        representatives[i] = (*vertexSimplices[vertexSets.Find(nodes[i]->GetRepresentative())])[0];
     }
 }
 
-template class FiltrationConstructor<double,2>;
\ No newline at end of file
+#define INSTANTIATE_FILTRATION_CONSTRUCTOR(T,D) template class FiltrationConstructor<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_FILTRATION_CONSTRUCTOR)
\ No newline at end of file
@@ -9,7 +9,10 @@
 #ifndef _FILTRATION_CONSTRUCTOR_H_
 #define _FILTRATION_CONSTRUCTOR_H_
 
+#include "DeltaBuckets.h"
+#include "FiltrationCounters.h"
 #include "Simplex.h"
+#include "UnionFind.h"
 #include "WSSD.h"
 
 #ifdef _WSSD_THREADS_
@@ -17,7 +20,6 @@
 #include <mutex>
 #endif //_WSSD_THREADS_
 
-#include <map>
 #include <vector>
 #include <set>
 
@@ -26,9 +28,30 @@
 template<typename T, int D>
 class Filtration;
 
+template<typename T, int D>
+class WspdConstructor;
+
+class Metrics;
+
+class Tracer;
+
+template<typename T, int D, int K>
+class WssdConstructor;
+
+template<typename T, int D>
+class KernelBenchmark;
+
 template<typename T, int D>
 class FiltrationConstructor
 {
+// Types
+private:
+    // The prepared K-tuples are stored at index K-1.
+    typedef std::vector<DeltaBuckets<T,D>>  TupleBuckets;
+
+    // Number of pairs that travel through the fused pipeline together.
+    static const int kFusedBatchSize = 4096;
+
 // Fields
 private:
     double                  epsilon;
@@ -42,27 +65,77 @@ private:
     std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator>  simplices;
 
     // Needed to improve speed
-    std::map<int, std::vector<std::set<Quadtree<T,D>*>>>        tuples;
+    TupleBuckets                                                tuples;
+
+    // Vertex bookkeeping for collapses, indexed by vertex id. A collapsed vertex is merged
+    // into the set of the vertex it was collapsed to.
+    UnionFind                                                   vertexSets;
+    std::vector<Simplex<T,D>*>                                  vertexSimplices;
+    std::vector<Quadtree<T,D>*>                                 vertexAncestors;   // Highest ancestor at the current theta
+    std::vector<unsigned int>                                   liveVertices;
+
+    // Scratch space reused by every collapse and simplex lookup, so neither allocates per call
+    Simplex<T,D>                                                probe;
+    std::vector<Quadtree<T,D>*>                                 repScratch;
+    unsigned int                                                starEpoch;
+    std::vector<Simplex<T,D>*>                                  starScratch;
+    std::vector<Simplex<T,D>*>                                  starStack;
 
 	int				highestDelta;
 
+    Metrics*        metrics;
+    Tracer*         tracer;
+
+    // Hot-path counts per delta, indexed by delta-minDelta. Preparing a tuple is counted at the
+    // delta it is added at, or discarded at. 'counters' counts the delta that is being added.
+    std::vector<FiltrationCounters>                             deltaCounters;
+    FiltrationCounters                                          counters;
+
 #ifdef _WSSD_THREADS_
     std::mutex		hdMutex;
     std::mutex      tuplesMutex;
 #endif //_WSSD_THREADS_
 
+    // Measures the private kernels in isolation
+    friend class KernelBenchmark<T,D>;
+
 // Constructors
 public:
     FiltrationConstructor(double eps, int minDelta, int maxDelta);
 
 // Functions:
 public:
+    /**
+     * Record the stages of the construction, including each delta, in 'metrics'. NULL disables it.
+     */
+    void SetMetrics(Metrics* metrics) { this->metrics = metrics; }
+
+    /**
+     * Trace the work of the threads, e.g. each batch of the fused pipeline, in 'tracer'. NULL disables it.
+     */
+    void SetTracer(Tracer* tracer) { this->tracer = tracer; }
+
+    /**
+     * The hot-path counts of the last construction, indexed by delta-minDelta.
+     */
+    const std::vector<FiltrationCounters>& GetDeltaCounters() const { return deltaCounters; }
+
     /**
      * Constructs the filtration for Delta in [minDelta, maxDelta]  =>  alpha = (1+eps)^Delta.
      * To conserve memory, it clears wssd.
      */
     void ConstructFiltration(WSSD<T,D>& wssd, Filtration<T,D>& retFiltration);
 
+    /**
+     * Constructs the filtration without materializing the WSSD. Batches of pairs found by
+     * 'wspdConstructor' are extended to 2-tuples by 'wssdConstructor' and both are sorted
+     * into their delta right away, after which the batch is discarded. When compiled with
+     * _WSSD_THREADS_ the WSPD traversal and the batch processing run on different threads,
+     * connected by a bounded queue.
+     */
+    void ConstructFiltration(Quadtree<T,D>* root, WspdConstructor<T,D>& wspdConstructor,
+        WssdConstructor<T,D,2>& wssdConstructor, Filtration<T,D>& retFiltration);
+
 // Inline methods:
 private:
 
@@ -85,14 +158,37 @@ private:
 	template<int K>
 	void AddToMap(const WellSeparatedTuple<T, D, K>& tuple);
 
+    /**
+     * Find the delta of each tuple in 'wssd' and store it in 'retTuples'.
+     */
+    template<int K>
+    void AddBatchToMap(const KWSSD(T,D,K)& wssd, TupleBuckets& retTuples, int& retHighestDelta,
+        std::vector<FiltrationCounters>& retCounters);
+
+    /**
+     * Extend a batch of pairs to 2-tuples, and add both to the tuples to be handled.
+     */
+    void PrepareBatch(const KWSSD(T,D,1)& pairs, Quadtree<T,D>* root, WssdConstructor<T,D,2>& wssdConstructor);
+
+    /**
+     * Sorts the prepared tuples by delta and adds their simplices to the filtration delta by delta.
+     */
+    void AddTuplesToFiltration(Filtration<T,D>& retFiltration);
+
+    /**
+     * Find the delta for each tuple in the K-WSSD. Does not clear the K-WSSD since the
+     * (K+1)-WSSD may still point into it.
+     */
     template<int K>
     void PrepareTuples(WSSD<T,D>& wssd);
 
     /**
-     * Finds the delta for which this tuple will be added to the filtration.
+     * Finds the delta for which this tuple will be added to the filtration. Its work is counted
+     * in 'retCounters', which belongs to 'retCountedDelta': the delta it is added or discarded at.
      */
     template<int K>
-    int FindTimeToAdd(const WellSeparatedTuple<T,D,K>& tuple, std::set<Quadtree<T,D>*>& retNodes);
+    int FindTimeToAdd(const WellSeparatedTuple<T,D,K>& tuple, std::set<Quadtree<T,D>*>& retNodes,
+        FiltrationCounters& retCounters, int& retCountedDelta);
 
     /**
      * Update all the vertices to new theta. If two vertices now map to the same node in the quadtree, it collapses
@@ -101,14 +197,19 @@ private:
     void UpdateToNewTheta(double theta, Filtration<T,D>& retFiltration);
 
     /**
-     * Adds a single vertex to the filtration if it doesn't exist.
+     * Adds a single vertex to the filtration if it doesn't exist. Returns its vertex id.
+     */
+    unsigned int AddVertexToFiltration(Quadtree<T,D>* node, Filtration<T,D>& retFiltration);
+
+    /**
+     * Reset the vertex bookkeeping.
      */
-    void AddVertexToFiltration(Quadtree<T,D>* node, Filtration<T,D>& retFiltration);
+    void ClearVertices();
 
     /**
      * Add a simplex to the filtration.
      */
-    void AddSimplexToFiltration(const std::set<Quadtree<T,D>*>& nodes, double theta, Filtration<T,D>& retFiltration);
+    void AddSimplexToFiltration(Quadtree<T,D>* const* nodes, int numNodes, double theta, Filtration<T,D>& retFiltration);
 
 
     /**
@@ -116,6 +217,18 @@ private:
      */
     void Collapse(Simplex<T,D>* u, Simplex<T,D>* v, double theta, Filtration<T,D>& retFiltration);
 
+    /**
+     * Get the closure of the star of 'simplex', sorted by Simplex::Comparator. Walks the star iteratively and marks
+     * visited simplices with a new epoch, so apart from growing 'retStarClosure' it does not allocate.
+     */
+    void GetStarClosure(Simplex<T,D>* simplex, std::vector<Simplex<T,D>*>& retStarClosure);
+
+    /**
+     * Obtain the representatives for an array of nodes. Assumes that the representatives of all 'nodes' are unique.
+     * Assumes that 'representatives' has size 'numNodes'. Not const since lookups compress paths in 'vertexSets'.
+     */
+    void GetRepresentatives(Quadtree<T,D>* const* nodes, int numNodes, std::vector<Quadtree<T,D>*>& representatives);
+
 
 
 
@@ -139,20 +252,9 @@ private:
 
     /**
      * Get the highest ancestor that has a diameter smaller than the one given.
-     * Assumes that diam(node) < maxDiam.
-     */
-    Quadtree<T,D>* GetHighestAncestor(Quadtree<T,D>* node, const double& maxDiam) const;
-
-    /**
-     * Get the closure of the star of 'simplex'.
-     */
-    void GetStarClosure(Simplex<T,D>* simplex, const Filtration<T,D>& filtration, std::set<Simplex<T,D>*, typename Simplex<T,D>::Comparator>& retStarClosure) const;
-
-    /**
-     * Obtain the representatives for a set of nodes. Assumes that the representatives of all 'nodes' are unique.
-     * Assumes that 'representatives' has the same size as 'nodes'.
+     * Assumes that diam(node) < maxDiam. The steps taken are added to 'retCounters' if given.
      */
-    void GetRepresentatives(const std::set<Quadtree<T,D>*>& nodes, std::vector<Quadtree<T,D>*>& representatives) const;
+    Quadtree<T,D>* GetHighestAncestor(Quadtree<T,D>* node, const double& maxDiam, FiltrationCounters* retCounters = NULL) const;
 };
 
 
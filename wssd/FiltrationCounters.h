@@ -0,0 +1,99 @@
+/**
+ * file: FiltrationCounters.h
+ * desc: Counts of the hot-path operations of the filtration construction. Each thread counts
+ *       into its own FiltrationCounters and they are added together once it is done, so the
+ *       counting itself needs no synchronization.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _FILTRATION_COUNTERS_H_
+#define _FILTRATION_COUNTERS_H_
+
+#include <algorithm>
+#include <vector>
+
+enum FiltrationCounter
+{
+    kMiniballCalls = 0,     // Minimum enclosing balls computed by GetDiam
+    kAncestorSteps,         // Parents visited by GetHighestAncestor
+    kSetLookups,            // Lookups in the set of simplices
+    kSetMisses,             // Lookups that didn't find the simplex
+    kCollapses,
+    kStarSimplices,         // Total size of the star closures that were collapsed
+    kMaxStarSize,           // Largest star closure that was collapsed
+    kDiscardedTuples,       // Tuples whose nodes merged into fewer than K+1 ancestors
+
+    kNumFiltrationCounters
+};
+
+static const char* filtrationCounterNames[kNumFiltrationCounters] =
+{
+    "miniball_calls",
+    "ancestor_steps",
+    "set_lookups",
+    "set_misses",
+    "collapses",
+    "star_simplices",
+    "max_star_size",
+    "discarded_tuples"
+};
+
+struct FiltrationCounters
+{
+    unsigned long long  values[kNumFiltrationCounters];
+
+    FiltrationCounters()
+    {
+        clear();
+    }
+
+    unsigned long long& operator[](FiltrationCounter counter)       { return values[counter]; }
+    unsigned long long  operator[](FiltrationCounter counter) const { return values[counter]; }
+
+    /**
+     * Adds the counts of 'other', the maxima are combined.
+     */
+    void Add(const FiltrationCounters& other)
+    {
+        for(int i=0; i<kNumFiltrationCounters; ++i)
+        {
+            values[i] = (i == kMaxStarSize ? std::max(values[i], other.values[i]) : values[i] + other.values[i]);
+        }
+    }
+
+    void clear()
+    {
+        std::fill(values, values + kNumFiltrationCounters, 0ULL);
+    }
+};
+
+/**
+ * Counters of the deltas from 'minDelta' on, grown to include 'delta' if needed.
+ */
+inline FiltrationCounters& GetCountersOfDelta(std::vector<FiltrationCounters>& perDelta, int minDelta, int delta)
+{
+    std::size_t index = std::size_t(delta - minDelta);
+    if(index >= perDelta.size())
+    {
+        perDelta.resize(index + 1);
+    }
+    return perDelta[index];
+}
+
+/**
+ * Adds the counters of every delta in 'other' to 'perDelta'.
+ */
+inline void AddCountersOfDeltas(std::vector<FiltrationCounters>& perDelta, const std::vector<FiltrationCounters>& other)
+{
+    if(other.size() > perDelta.size())
+    {
+        perDelta.resize(other.size());
+    }
+    for(std::size_t i = 0; i < other.size(); ++i)
+    {
+        perDelta[i].Add(other[i]);
+    }
+}
+
+#endif //_FILTRATION_COUNTERS_H_
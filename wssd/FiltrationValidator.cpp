@@ -9,6 +9,7 @@
 #include "FiltrationConstructor.h"
 
 #include "FiltrationValidator.h"
+#include "Instantiations.h"
 
 template<typename T, int D>
 bool FiltrationValidator<T,D>::ValidateFiltration(const Filtration<T,D>& filtration) const
@@ -43,4 +44,5 @@ bool FiltrationValidator<T,D>::TestPointers(const Filtration<T,D>& filtration) c
     return retVal;
 }
 
-template class FiltrationValidator<double,2>;
\ No newline at end of file
+#define INSTANTIATE_FILTRATION_VALIDATOR(T,D) template class FiltrationValidator<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_FILTRATION_VALIDATOR)
\ No newline at end of file
@@ -0,0 +1,74 @@
+/**
+ * file: Instantiations.h
+ * desc: The scalar types and dimensions the templates are instantiated for. Every .cpp ends with
+ *       WSSD_INSTANTIATE of a macro that instantiates its classes for one T and D, so adding a
+ *       dimension only takes a line here and a case in DispatchInstantiation.
+ *
+ *       DispatchInstantiation picks the instantiation at runtime, e.g. from the header of a
+ *       PointFile, so a single executable handles all of them.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _INSTANTIATIONS_H_
+#define _INSTANTIATIONS_H_
+
+#include "PointFile.h"
+
+// Applies INSTANTIATE(T, D) to both scalar types of dimension D
+#define WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, D)  \
+    INSTANTIATE(float, D)                           \
+    INSTANTIATE(double, D)
+
+// Applies INSTANTIATE(T, D) to every instantiation
+#define WSSD_INSTANTIATE(INSTANTIATE)               \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 2)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 3)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 4)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 5)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 6)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 7)      \
+    WSSD_INSTANTIATE_DIMENSION(INSTANTIATE, 8)
+
+static const int kMinInstantiatedDimension = 2;
+static const int kMaxInstantiatedDimension = 8;
+
+/**
+ * Calls function.Run<T,D>() for the scalar type of 'scalarType'.
+ */
+template<int D, typename Function>
+void DispatchScalarType(PointScalarType scalarType, Function& function)
+{
+    if(scalarType == kScalarFloat)
+    {
+        function.template Run<float,D>();
+    }
+    else
+    {
+        function.template Run<double,D>();
+    }
+}
+
+/**
+ * Calls function.Run<T,D>() with the instantiation for 'scalarType' and 'dimension'. 'function'
+ * is an object with a member template Run, it keeps the arguments and results of the call.
+ * Returns false if the dimension isn't instantiated, Run isn't called then.
+ */
+template<typename Function>
+bool DispatchInstantiation(PointScalarType scalarType, int dimension, Function& function)
+{
+    switch(dimension)
+    {
+    case 2: DispatchScalarType<2>(scalarType, function); return true;
+    case 3: DispatchScalarType<3>(scalarType, function); return true;
+    case 4: DispatchScalarType<4>(scalarType, function); return true;
+    case 5: DispatchScalarType<5>(scalarType, function); return true;
+    case 6: DispatchScalarType<6>(scalarType, function); return true;
+    case 7: DispatchScalarType<7>(scalarType, function); return true;
+    case 8: DispatchScalarType<8>(scalarType, function); return true;
+    default:
+        return false;
+    }
+}
+
+#endif //_INSTANTIATIONS_H_
@@ -0,0 +1,167 @@
+/**
+ * file: MappedFile.h
+ * desc: Maps a whole file into memory. The mapping is copy-on-write: the contents can be
+ *       modified in memory without changing the file, and only pages that are written to are
+ *       copied.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+// Fields
+private:
+    char*               data;
+    unsigned long long  numBytes;
+
+#ifdef _WIN32
+    HANDLE              file;
+    HANDLE              mapping;
+#endif
+
+// Constructors
+public:
+    MappedFile()
+    : data(NULL)
+    , numBytes(0)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE)
+    , mapping(NULL)
+#endif
+    {}
+
+    ~MappedFile() { Close(); }
+
+private:
+    // The mapping can't be shared
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+// Functions
+public:
+    /**
+     * Maps the file into memory. Closes a previously opened file. Returns if the operation was
+     * successful. An empty file is opened successfully but has no data.
+     */
+    bool Open(const std::string& strFilename)
+    {
+        Close();
+
+        bool success = false;
+
+#ifdef _WIN32
+        file = CreateFileA(strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if(file != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER size;
+            if(GetFileSizeEx(file, &size))
+            {
+                numBytes = (unsigned long long)(size.QuadPart);
+                if(numBytes == 0)
+                {
+                    success = true;
+                }
+                else
+                {
+                    mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+                    if(mapping != NULL)
+                    {
+                        data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+                        success = (data != NULL);
+                    }
+                }
+            }
+        }
+#else
+        int fd = open(strFilename.c_str(), O_RDONLY);
+        if(fd >= 0)
+        {
+            struct stat status;
+            if(fstat(fd, &status) == 0)
+            {
+                numBytes = (unsigned long long)(status.st_size);
+                if(numBytes == 0)
+                {
+                    success = true;
+                }
+                else
+                {
+                    // Private mappings are copy-on-write
+                    void* address = mmap(NULL, std::size_t(numBytes), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                    if(address != MAP_FAILED)
+                    {
+                        data = static_cast<char*>(address);
+                        madvise(address, std::size_t(numBytes), MADV_SEQUENTIAL);
+                        success = true;
+                    }
+                }
+            }
+
+            // The mapping stays valid after closing the descriptor
+            close(fd);
+        }
+#endif
+
+        if(!success)
+        {
+            Close();
+        }
+        return success;
+    }
+
+    /**
+     * Unmaps the file. Invalidates all pointers into the data.
+     */
+    void Close()
+    {
+#ifdef _WIN32
+        if(data != NULL)
+        {
+            UnmapViewOfFile(data);
+        }
+        if(mapping != NULL)
+        {
+            CloseHandle(mapping);
+            mapping = NULL;
+        }
+        if(file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if(data != NULL)
+        {
+            munmap(data, std::size_t(numBytes));
+        }
+#endif
+
+        data     = NULL;
+        numBytes = 0;
+    }
+
+    char*               GetData() const { return data; }
+    unsigned long long  GetSize() const { return numBytes; }
+};
+
+#endif //_MAPPED_FILE_H_
@@ -0,0 +1,139 @@
+/**
+ * file: MappedPointSet.h
+ * desc: Maps a binary point set file (as written by PointSetIO) into memory instead of reading
+ *       it, so loading takes constant time and pages are only read from disk when the points are
+ *       accessed. The points can be modified in memory without changing the file. Files in the
+ *       self-describing PointFile format are recognized by their header.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _MAPPED_POINT_SET_H_
+#define _MAPPED_POINT_SET_H_
+
+#include <iostream>
+#include <string>
+
+#include "MappedFile.h"
+#include "PointFile.h"
+#include "PointSpan.h"
+
+template<typename T, int D>
+class MappedPointSet
+{
+// Fields
+private:
+    MappedFile          file;
+
+    bool                hasHeader;
+    PointFileHeader     header;
+
+// Constructors
+public:
+    MappedPointSet()
+    : hasHeader(false)
+    {}
+
+// Functions
+public:
+    /**
+     * Maps the file into memory. Closes a previously opened file. Returns if the operation was successful.
+     */
+    bool Open(const std::string& strFilename, bool bVerbose = true);
+
+    /**
+     * Unmaps the file. Invalidates all spans obtained from GetPoints.
+     */
+    void Close();
+
+    /**
+     * The points in the file. Trailing bytes that don't form a whole point are ignored.
+     */
+    PointSpan<T,D> GetPoints() const
+    {
+        if(hasHeader)
+        {
+            return PointSpan<T,D>(reinterpret_cast<vec<T,D>*>(file.GetData() + header.dataOffset), std::size_t(header.numPoints));
+        }
+        return PointSpan<T,D>(reinterpret_cast<vec<T,D>*>(file.GetData()), std::size_t(file.GetSize()/sizeof(vec<T,D>)));
+    }
+
+    /**
+     * Gets the bounding box stored in the header of a PointFile. Returns false for raw files.
+     */
+    bool GetBounds(vec<T,D>& retMin, vec<T,D>& retMax) const
+    {
+        if(!hasHeader)
+        {
+            return false;
+        }
+        for(int d=0; d<D; ++d)
+        {
+            retMin[d] = T(header.minPoint[d]);
+            retMax[d] = T(header.maxPoint[d]);
+        }
+        return true;
+    }
+};
+
+
+
+template<typename T, int D>
+bool MappedPointSet<T,D>::Open(const std::string& strFilename, bool bVerbose)
+{
+    Close();
+
+    // Self-describing files can only be mapped if they store exactly vec<T,D>
+    hasHeader = header.Read(strFilename);
+    if(!hasHeader && PointFileHeader::HasMagic(strFilename))
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" has a corrupt point file header. No points loaded." << std::endl;
+        }
+        return false;
+    }
+    if(hasHeader && (header.dimension != D || header.scalarType != PointScalarTypeOf<T>::value))
+    {
+        hasHeader = false;
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" doesn't store points of this dimension and type. No points loaded." << std::endl;
+        }
+        return false;
+    }
+
+    bool success = file.Open(strFilename);
+
+    // Divide rather than multiply, so a corrupt number of points can't wrap around
+    if(success && hasHeader && (header.dataOffset > file.GetSize() || header.dataOffset % sizeof(T) != 0 ||
+        header.numPoints > (file.GetSize() - header.dataOffset) / sizeof(vec<T,D>)))
+    {
+        success = false;
+    }
+
+    if(!success)
+    {
+        Close();
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" could not be mapped. No points loaded." << std::endl;
+        }
+        return false;
+    }
+
+    if(bVerbose)
+    {
+        std::cout << "Mapped " << GetPoints().size() << " points from file: \"" << strFilename.c_str() << "\"." << std::endl;
+    }
+    return true;
+}
+
+template<typename T, int D>
+void MappedPointSet<T,D>::Close()
+{
+    file.Close();
+    hasHeader = false;
+}
+
+#endif //_MAPPED_POINT_SET_H_
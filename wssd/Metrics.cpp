@@ -0,0 +1,231 @@
+/**
+ * file: Metrics.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Assert.h"
+#include "Metrics.h"
+#include "Trace.h"
+
+/**
+ * Writes 'str' as a JSON string.
+ */
+static void WriteJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for(auto it = str.cbegin(); it != str.cend(); ++it)
+    {
+        if(*it == '"' || *it == '\\')
+        {
+            out << '\\';
+        }
+        out << *it;
+    }
+    out << '"';
+}
+
+bool Metrics::EnablePerfCounters()
+{
+    return perfCounters.Open();
+}
+
+void Metrics::SetParameter(const std::string& name, const std::string& value)
+{
+    std::ostringstream str;
+    WriteJsonString(str, value);
+    parameters.push_back(std::make_pair(name, str.str()));
+}
+
+void Metrics::SetParameter(const std::string& name, double value)
+{
+    std::ostringstream str;
+    str.precision(17);
+    str << value;
+    parameters.push_back(std::make_pair(name, str.str()));
+}
+
+void Metrics::BeginStage(const std::string& name)
+{
+    Stage stage;
+    stage.name = name;
+    stage.depth = int(openStages.size());
+    stage.wallMs = 0.0;
+    stage.cpuMs = 0.0;
+    stage.peakRssBytes = 0;
+    stages.push_back(stage);
+
+    OpenStage open;
+    open.index = stages.size() - 1;
+    open.cpuStartMs = GetProcessCpuMs();
+    perfCounters.Read(open.countersStart);
+    open.traceBeginUs = (tracer != NULL ? tracer->Now() : 0.0);
+    openStages.push_back(open);
+    openStages.back().timer.Start();
+}
+
+void Metrics::EndStage()
+{
+    ASSERT(!openStages.empty());
+    if(openStages.empty())
+    {
+        return;
+    }
+
+    OpenStage& open = openStages.back();
+    Stage& stage = stages[open.index];
+    stage.wallMs = open.timer.Stop();
+    stage.cpuMs = GetProcessCpuMs() - open.cpuStartMs;
+    stage.peakRssBytes = GetPeakRssBytes();
+
+    if(tracer != NULL)
+    {
+        tracer->GetThreadBuffer()->AddSpan(stage.name.c_str(), open.traceBeginUs, tracer->Now(), -1);
+    }
+
+    if(perfCounters.IsOpen())
+    {
+        PerfCounterValues counters;
+        perfCounters.Read(counters);
+        for(int i=0; i<kNumPerfCounters; ++i)
+        {
+            if(counters.valid[i] && open.countersStart.valid[i])
+            {
+                stage.counts.push_back(std::make_pair(std::string(perfCounterNames[i]), counters.values[i] - open.countersStart.values[i]));
+            }
+        }
+    }
+
+    openStages.pop_back();
+}
+
+void Metrics::AddCount(const std::string& name, unsigned long long value)
+{
+    if(stages.empty())
+    {
+        return;
+    }
+
+    Stage& stage = (openStages.empty() ? stages.back() : stages[openStages.back().index]);
+    stage.counts.push_back(std::make_pair(name, value));
+}
+
+void Metrics::WriteJson(std::ostream& out) const
+{
+    out << "{\n  \"parameters\": {";
+    for(std::size_t i=0; i<parameters.size(); ++i)
+    {
+        out << (i == 0 ? "\n    " : ",\n    ");
+        WriteJsonString(out, parameters[i].first);
+        out << ": " << parameters[i].second;
+    }
+    out << (parameters.empty() ? "},\n" : "\n  },\n");
+
+    out << "  \"stages\": [";
+    for(std::size_t i=0; i<stages.size(); ++i)
+    {
+        const Stage& stage = stages[i];
+
+        char times[96];
+        sprintf_s(times, "\"wall_ms\": %.3f, \"cpu_ms\": %.3f", stage.wallMs, stage.cpuMs);
+
+        out << (i == 0 ? "\n    {" : ",\n    {") << "\"name\": ";
+        WriteJsonString(out, stage.name);
+        out << ", \"depth\": " << stage.depth << ", " << times << ", \"peak_rss_bytes\": " << stage.peakRssBytes;
+
+        out << ", \"counts\": {";
+        for(std::size_t j=0; j<stage.counts.size(); ++j)
+        {
+            out << (j == 0 ? "" : ", ");
+            WriteJsonString(out, stage.counts[j].first);
+            out << ": " << stage.counts[j].second;
+        }
+        out << "}}";
+    }
+    out << (stages.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+bool Metrics::WriteJson(const std::string& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if(!file.is_open())
+    {
+        printf("File couldn't be opened. Did not save metrics.\n");
+        return false;
+    }
+
+    WriteJson(file);
+    return true;
+}
+
+void Metrics::clear()
+{
+    parameters.clear();
+    stages.clear();
+    openStages.clear();
+}
+
+double Metrics::GetProcessCpuMs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return 0.0;
+    }
+
+    // FILETIMEs count 100 nanosecond intervals
+    unsigned long long k = ((unsigned long long)(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    unsigned long long u = ((unsigned long long)(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return double(k + u)*1e-4;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0.0;
+    }
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)*1000.0 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)*1e-3;
+#endif
+}
+
+unsigned long long Metrics::GetPeakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+    // Linux reports kilobytes
+    return (unsigned long long)(usage.ru_maxrss)*1024ull;
+#endif
+}
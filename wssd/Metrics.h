@@ -0,0 +1,161 @@
+/**
+ * file: Metrics.h
+ * desc: Collects per-stage measurements of a run: wall time, CPU time of the process, peak
+ *       resident set size and element counts, and optionally the hardware counters of
+ *       PerfCounters. Stages can be nested, e.g. the deltas of the
+ *       filtration construction within the filtration stage. The result is written as JSON so
+ *       runs can be compared.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CpuTimer.h"
+#include "PerfCounters.h"
+
+// Forward class declarations
+class Tracer;
+
+class Metrics
+{
+// Types
+public:
+    struct Stage
+    {
+        std::string     name;
+        int             depth;          // Number of enclosing stages
+        double          wallMs;
+        double          cpuMs;          // User and system time of all threads
+        unsigned long long peakRssBytes;   // Peak resident set size of the process at the end of the stage
+
+        std::vector<std::pair<std::string, unsigned long long>> counts;
+    };
+
+// Fields
+private:
+    std::vector<std::pair<std::string, std::string>>   parameters;
+    std::vector<Stage>                                  stages;
+
+    // Open stages, innermost last
+    struct OpenStage
+    {
+        std::size_t     index;
+        CpuTimer        timer;
+        double          cpuStartMs;
+        PerfCounterValues countersStart;
+        double          traceBeginUs;
+    };
+    std::vector<OpenStage>                              openStages;
+
+    PerfCounters                                        perfCounters;
+    Tracer*                                             tracer;
+
+// Constructors
+public:
+    Metrics() : tracer(NULL) {}
+
+// Functions
+public:
+    /**
+     * Adds the hardware counters to the counts of every stage that begins after this call.
+     * Returns false if they are not available, see PerfCounters.
+     */
+    bool EnablePerfCounters();
+
+    /**
+     * Also trace every stage as a span of the thread that ends it. NULL disables it.
+     */
+    void SetTracer(Tracer* tracer) { this->tracer = tracer; }
+
+    /**
+     * Records a parameter of the run, e.g. the number of points or epsilon.
+     */
+    void SetParameter(const std::string& name, const std::string& value);
+    void SetParameter(const std::string& name, double value);
+
+    /**
+     * Starts a new stage within the currently open stage, if any.
+     */
+    void BeginStage(const std::string& name);
+
+    /**
+     * Ends the innermost open stage.
+     */
+    void EndStage();
+
+    /**
+     * Adds a count to the innermost open stage, or to the last stage if none is open.
+     */
+    void AddCount(const std::string& name, unsigned long long value);
+
+    const std::vector<Stage>& GetStages() const { return stages; }
+
+    /**
+     * Writes the parameters and stages as JSON.
+     */
+    void WriteJson(std::ostream& out) const;
+
+    /**
+     * Writes the parameters and stages as JSON to a file. Returns if the operation was successful.
+     */
+    bool WriteJson(const std::string& filename) const;
+
+    /**
+     * Clears all parameters and stages.
+     */
+    void clear();
+
+    /**
+     * CPU time used by the process so far, in milliseconds.
+     */
+    static double GetProcessCpuMs();
+
+    /**
+     * Peak resident set size of the process so far, in bytes.
+     */
+    static unsigned long long GetPeakRssBytes();
+
+private:
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+};
+
+/**
+ * Measures a stage for the lifetime of the object. Does nothing if 'metrics' is NULL.
+ */
+class ScopedStage
+{
+private:
+    Metrics* metrics;
+
+public:
+    ScopedStage(Metrics* metrics, const std::string& name)
+    : metrics(metrics)
+    {
+        if(metrics != NULL)
+        {
+            metrics->BeginStage(name);
+        }
+    }
+
+    ~ScopedStage()
+    {
+        if(metrics != NULL)
+        {
+            metrics->EndStage();
+        }
+    }
+
+private:
+    ScopedStage(const ScopedStage&);
+    ScopedStage& operator=(const ScopedStage&);
+};
+
+#endif //_METRICS_H_
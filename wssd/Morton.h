@@ -0,0 +1,44 @@
+/**
+ * file: Morton.h
+ * desc: Morton (Z-order) codes for points in a quadtree cell. Sorting by the code gives
+ *       the order in which a depth-first traversal of the quadtree visits the points.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _MORTON_H_
+#define _MORTON_H_
+
+#include "Vec.h"
+
+/**
+ * Returns the Morton code of 'p' in the cell [minPoint, minPoint + sideLength]^D. Each
+ * dimension is quantized to 64/D bits, points outside of the cell are clamped to it.
+ */
+template<typename T, int D>
+unsigned long long MortonCode(const vec<T,D>& p, const vec<T,D>& minPoint, T sideLength)
+{
+    const int bits = 64/D;
+    const double cells = double(1ull << (bits-1))*2.0;
+
+    unsigned long long coord[D];
+    for(int d=0; d<D; ++d)
+    {
+        double c = (sideLength > T(0) ? double(p[d] - minPoint[d])/double(sideLength) : 0.0)*cells;
+        c = std::min(std::max(c, 0.0), cells - 1.0);
+        coord[d] = (unsigned long long)(c);
+    }
+
+    // Interleave the bits, most significant first
+    unsigned long long code = 0;
+    for(int b=bits-1; b>=0; --b)
+    {
+        for(int d=D-1; d>=0; --d)
+        {
+            code = (code << 1) | ((coord[d] >> b) & 1ull);
+        }
+    }
+    return code;
+}
+
+#endif //_MORTON_H_
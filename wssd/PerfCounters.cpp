@@ -0,0 +1,136 @@
+/**
+ * file: PerfCounters.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <cstring>
+
+#if defined(_WSSD_PERF_COUNTERS_) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "PerfCounters.h"
+
+#if defined(_WSSD_PERF_COUNTERS_) && defined(__linux__)
+
+/**
+ * Type and config of the event that measures each counter.
+ */
+static void GetEvent(PerfCounter counter, unsigned int& retType, unsigned long long& retConfig)
+{
+    const unsigned long long readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    switch(counter)
+    {
+    case kCycles:
+        retType = PERF_TYPE_HARDWARE;
+        retConfig = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case kInstructions:
+        retType = PERF_TYPE_HARDWARE;
+        retConfig = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case kL1dMisses:
+        retType = PERF_TYPE_HW_CACHE;
+        retConfig = PERF_COUNT_HW_CACHE_L1D | readMiss;
+        break;
+    case kLlcMisses:
+        retType = PERF_TYPE_HW_CACHE;
+        retConfig = PERF_COUNT_HW_CACHE_LL | readMiss;
+        break;
+    case kBranchMisses:
+    default:
+        retType = PERF_TYPE_HARDWARE;
+        retConfig = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+#endif
+
+PerfCounters::PerfCounters()
+{
+    for(int i=0; i<kNumPerfCounters; ++i)
+    {
+        fds[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    Close();
+}
+
+bool PerfCounters::Open()
+{
+    Close();
+
+#if defined(_WSSD_PERF_COUNTERS_) && defined(__linux__)
+    for(int i=0; i<kNumPerfCounters; ++i)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        GetEvent(PerfCounter(i), attr.type, attr.config);
+
+        // Only user space, which is also allowed at the default perf_event_paranoid level
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        fds[i] = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    return IsOpen();
+}
+
+void PerfCounters::Close()
+{
+#if defined(_WSSD_PERF_COUNTERS_) && defined(__linux__)
+    for(int i=0; i<kNumPerfCounters; ++i)
+    {
+        if(fds[i] >= 0)
+        {
+            close(fds[i]);
+        }
+        fds[i] = -1;
+    }
+#endif
+}
+
+bool PerfCounters::IsOpen() const
+{
+    for(int i=0; i<kNumPerfCounters; ++i)
+    {
+        if(fds[i] >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::Read(PerfCounterValues& retValues) const
+{
+    for(int i=0; i<kNumPerfCounters; ++i)
+    {
+        retValues.values[i] = 0;
+        retValues.valid[i] = false;
+
+#if defined(_WSSD_PERF_COUNTERS_) && defined(__linux__)
+        // Value, time enabled, time running
+        unsigned long long data[3];
+        if(fds[i] >= 0 && read(fds[i], data, sizeof(data)) == sizeof(data))
+        {
+            retValues.values[i] = (data[2] > 0 && data[2] < data[1] ? (unsigned long long)(double(data[0])*data[1]/data[2]) : data[0]);
+            retValues.valid[i] = true;
+        }
+#endif
+    }
+}
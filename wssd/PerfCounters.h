@@ -0,0 +1,82 @@
+/**
+ * file: PerfCounters.h
+ * desc: Hardware performance counters of the process: cycles, instructions, L1 data and last
+ *       level cache misses, and branch misses. Uses perf_event_open, so they are only
+ *       available on Linux when compiled with _WSSD_PERF_COUNTERS_. Otherwise Open fails and
+ *       the counters are simply not reported.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+enum PerfCounter
+{
+    kCycles = 0,
+    kInstructions,
+    kL1dMisses,
+    kLlcMisses,
+    kBranchMisses,
+
+    kNumPerfCounters
+};
+
+static const char* perfCounterNames[kNumPerfCounters] =
+{
+    "cycles",
+    "instructions",
+    "l1d_misses",
+    "llc_misses",
+    "branch_misses"
+};
+
+/**
+ * A reading of the counters. Counters the CPU doesn't support are not valid.
+ */
+struct PerfCounterValues
+{
+    unsigned long long  values[kNumPerfCounters];
+    bool                valid[kNumPerfCounters];
+};
+
+class PerfCounters
+{
+// Fields
+private:
+    int     fds[kNumPerfCounters];
+
+// Constructors
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+// Functions
+public:
+    /**
+     * Starts counting for the calling thread and the threads it creates afterwards, which are
+     * added to the counts when they are joined. Returns false if no counter could be opened.
+     */
+    bool Open();
+
+    /**
+     * Stops counting.
+     */
+    void Close();
+
+    /**
+     * If any counter is counting.
+     */
+    bool IsOpen() const;
+
+    /**
+     * Reads the counters. Values are scaled up when the kernel had to multiplex the counters.
+     */
+    void Read(PerfCounterValues& retValues) const;
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+};
+
+#endif //_PERF_COUNTERS_H_
@@ -0,0 +1,77 @@
+/**
+ * file: PerfStats.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <cstdio>
+
+#include "PerfStats.h"
+
+void PerfStats::PrintStats(const Metrics& metrics) const
+{
+    const std::vector<Metrics::Stage>& stages = metrics.GetStages();
+
+    bool recorded = false;
+    for(auto it = stages.cbegin(); it != stages.cend(); ++it)
+    {
+        unsigned long long cycles;
+        recorded = recorded || GetCount(*it, perfCounterNames[kCycles], cycles);
+    }
+    if(!recorded)
+    {
+        return;
+    }
+
+    printf("\n\nPerf counter stats:\n\n%-32s %10s %14s %6s %10s %10s %10s\n",
+        "stage", "wall ms", "cycles", "IPC", "L1d/kI", "LLC/kI", "branch/kI");
+
+    for(auto it = stages.cbegin(); it != stages.cend(); ++it)
+    {
+        unsigned long long values[kNumPerfCounters];
+        bool valid[kNumPerfCounters];
+        for(int i=0; i<kNumPerfCounters; ++i)
+        {
+            valid[i] = GetCount(*it, perfCounterNames[i], values[i]);
+        }
+
+        // Indent nested stages
+        std::string name = std::string(2*it->depth, ' ') + it->name;
+        printf("%-32s %10.2f ", name.c_str(), it->wallMs);
+
+        if(valid[kCycles])
+            printf("%14llu ", values[kCycles]);
+        else
+            printf("%14s ", "-");
+
+        if(valid[kCycles] && valid[kInstructions] && values[kCycles] > 0)
+            printf("%6.2f", double(values[kInstructions])/values[kCycles]);
+        else
+            printf("%6s", "-");
+
+        // Misses per thousand instructions
+        const PerfCounter misses[] = { kL1dMisses, kLlcMisses, kBranchMisses };
+        for(int i=0; i<3; ++i)
+        {
+            if(valid[misses[i]] && valid[kInstructions] && values[kInstructions] > 0)
+                printf(" %10.3f", 1000.0*values[misses[i]]/values[kInstructions]);
+            else
+                printf(" %10s", "-");
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+bool PerfStats::GetCount(const Metrics::Stage& stage, const std::string& name, unsigned long long& retValue) const
+{
+    for(auto it = stage.counts.cbegin(); it != stage.counts.cend(); ++it)
+    {
+        if(it->first == name)
+        {
+            retValue = it->second;
+            return true;
+        }
+    }
+    return false;
+}
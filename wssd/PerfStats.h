@@ -0,0 +1,31 @@
+/**
+ * file: PerfStats.h
+ * desc: Reports the hardware counters that Metrics recorded per stage.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _PERF_STATS_H_
+#define _PERF_STATS_H_
+
+#include <string>
+
+#include "Metrics.h"
+
+class PerfStats
+{
+public:
+    /**
+     * Prints a table of the stages with their cycles, instructions per cycle and the misses per
+     * thousand instructions to the std out. Prints nothing if no counters were recorded.
+     */
+    void PrintStats(const Metrics& metrics) const;
+
+private:
+    /**
+     * Gets a count of the stage. Returns false if the stage doesn't have it.
+     */
+    bool GetCount(const Metrics::Stage& stage, const std::string& name, unsigned long long& retValue) const;
+};
+
+#endif //_PERF_STATS_H_
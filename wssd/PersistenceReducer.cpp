@@ -0,0 +1,230 @@
+/**
+ * file: PersistenceReducer.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#ifdef _WSSD_THREADS_
+#include <thread>
+#endif //_WSSD_THREADS_
+
+#include "Assert.h"
+#include "Simplex.h"
+#include "PersistenceReducer.h"
+#include "Instantiations.h"
+
+// Marks a row that is not the pivot of any column
+static const unsigned int kNone = 0xFFFFFFFF;
+
+template<typename T, int D>
+PersistenceReducer<T,D>::PersistenceReducer()
+: parallel(false)
+{}
+
+template<typename T, int D>
+void PersistenceReducer<T,D>::ComputePairs(const Filtration<T,D>& filtration, std::vector<PersistencePair>& retPairs, bool includeZeroPersistence)
+{
+    const std::size_t numColumns = filtration.simplices.size();
+
+    BuildColumns(filtration);
+
+    reduced.assign(numColumns, std::vector<unsigned int>());
+    pivotColumn.assign(numColumns, kNone);
+    cleared.reset(new std::atomic<bool>[numColumns]);
+    for(std::size_t j=0; j<numColumns; ++j)
+    {
+        cleared[j].store(false, std::memory_order_relaxed);
+    }
+
+    // Vertices have empty columns, so they need no reduction
+    const int maxDimension = int(columnsOfDimension.size()) - 1;
+
+#ifdef _WSSD_THREADS_
+    if(parallel)
+    {
+        std::vector<std::thread> threads;
+        for(int d=maxDimension; d>0; --d)
+        {
+            threads.push_back(std::thread(&PersistenceReducer<T,D>::ReduceDimension, this, d));
+        }
+        for(auto it = threads.begin(); it != threads.end(); ++it)
+        {
+            it->join();
+        }
+    }
+    else
+#endif //_WSSD_THREADS_
+    {
+        // High to low, so each dimension is cleared completely before it is reduced
+        for(int d=maxDimension; d>0; --d)
+        {
+            ReduceDimension(d);
+        }
+    }
+
+    // Read off the pairs. A column is the birth of an essential class if it has reduced to
+    // zero and no other column has it as pivot.
+    retPairs.clear();
+    for(int d=0; d<=maxDimension; ++d)
+    {
+        const std::vector<unsigned int>& columns = columnsOfDimension[d];
+        for(auto it = columns.cbegin(); it != columns.cend(); ++it)
+        {
+            const unsigned int j = *it;
+            const double value = filtration.simplices[j]->GetFunctionValue()/2.0;
+
+            if(!reduced[j].empty())
+            {
+                // j kills the class born at its pivot
+                const unsigned int birth = reduced[j].back();
+                const double birthValue = filtration.simplices[birth]->GetFunctionValue()/2.0;
+
+                if(includeZeroPersistence || birthValue < value)
+                {
+                    PersistencePair pair = { d-1, birth, j, birthValue, value };
+                    retPairs.push_back(pair);
+                }
+            }
+            else if(pivotColumn[j] == kNone)
+            {
+                PersistencePair pair = { d, j, PersistencePair::kEssential, value, std::numeric_limits<double>::infinity() };
+                retPairs.push_back(pair);
+            }
+        }
+    }
+
+    // Pairs were read off per dimension of the killing simplex, so sort by dimension of the class.
+    // Essential classes have the largest death index, so they end up last.
+    std::sort(retPairs.begin(), retPairs.end(), [](const PersistencePair& lhs, const PersistencePair& rhs)
+    {
+        if(lhs.dimension != rhs.dimension)
+        {
+            return lhs.dimension < rhs.dimension;
+        }
+        if(lhs.deathIndex != rhs.deathIndex)
+        {
+            return lhs.deathIndex < rhs.deathIndex;
+        }
+        return lhs.birthIndex < rhs.birthIndex;
+    });
+
+    clear();
+}
+
+template<typename T, int D>
+void PersistenceReducer<T,D>::PrintStats(const std::vector<PersistencePair>& pairs) const
+{
+    std::vector<std::size_t> finite;
+    std::vector<std::size_t> essential;
+    for(auto it = pairs.cbegin(); it != pairs.cend(); ++it)
+    {
+        if(it->dimension >= int(finite.size()))
+        {
+            finite.resize(it->dimension + 1, 0);
+            essential.resize(it->dimension + 1, 0);
+        }
+        ++(it->deathIndex == PersistencePair::kEssential ? essential : finite)[it->dimension];
+    }
+
+    for(std::size_t d=0; d<finite.size(); ++d)
+    {
+        printf("Dimension %u: %u finite pairs, %u essential classes\n", (unsigned int)d, (unsigned int)finite[d], (unsigned int)essential[d]);
+    }
+}
+
+template<typename T, int D>
+void PersistenceReducer<T,D>::BuildColumns(const Filtration<T,D>& filtration)
+{
+    const std::size_t numColumns = filtration.simplices.size();
+
+    offsets.assign(1, 0);
+    offsets.reserve(numColumns + 1);
+    rows.clear();
+    columnsOfDimension.clear();
+
+    for(std::size_t j=0; j<numColumns; ++j)
+    {
+        Simplex<T,D>* simplex = filtration.simplices[j];
+        const int k = simplex->GetK();
+
+        if(k >= int(columnsOfDimension.size()))
+        {
+            columnsOfDimension.resize(k + 1);
+        }
+        columnsOfDimension[k].push_back((unsigned int)j);
+
+        if(k > 0)
+        {
+            const std::vector<Simplex<T,D>*>& boundary = simplex->GetBoundary();
+            const std::size_t first = rows.size();
+            for(auto it = boundary.cbegin(); it != boundary.cend(); ++it)
+            {
+                ASSERT((*it)->GetIndex() < j);
+                rows.push_back((*it)->GetIndex());
+            }
+            std::sort(rows.begin() + first, rows.end());
+        }
+        offsets.push_back(rows.size());
+    }
+}
+
+template<typename T, int D>
+void PersistenceReducer<T,D>::ReduceDimension(int dimension)
+{
+    std::vector<unsigned int> column;
+    std::vector<unsigned int> sum;
+
+    const std::vector<unsigned int>& columns = columnsOfDimension[dimension];
+    for(auto it = columns.cbegin(); it != columns.cend(); ++it)
+    {
+        const unsigned int j = *it;
+        if(cleared[j].load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+
+        column.assign(rows.begin() + offsets[j], rows.begin() + offsets[j+1]);
+
+        // Add reduced columns with the same pivot until the pivot is new, or nothing is left
+        while(!column.empty())
+        {
+            const unsigned int left = pivotColumn[column.back()];
+            if(left == kNone)
+            {
+                break;
+            }
+
+            const std::vector<unsigned int>& other = reduced[left];
+            sum.clear();
+            std::set_symmetric_difference(column.begin(), column.end(), other.begin(), other.end(), std::back_inserter(sum));
+            column.swap(sum);
+        }
+
+        if(!column.empty())
+        {
+            // The pivot row is a column of the dimension below that will reduce to zero
+            pivotColumn[column.back()] = j;
+            cleared[column.back()].store(true, std::memory_order_relaxed);
+            reduced[j] = column;
+        }
+    }
+}
+
+template<typename T, int D>
+void PersistenceReducer<T,D>::clear()
+{
+    std::vector<std::size_t>().swap(offsets);
+    std::vector<unsigned int>().swap(rows);
+    std::vector<std::vector<unsigned int>>().swap(columnsOfDimension);
+    std::vector<std::vector<unsigned int>>().swap(reduced);
+    std::vector<unsigned int>().swap(pivotColumn);
+    cleared.reset();
+}
+
+#define INSTANTIATE_PERSISTENCE_REDUCER(T,D) template class PersistenceReducer<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_PERSISTENCE_REDUCER)
@@ -0,0 +1,104 @@
+/**
+ * file: PersistenceReducer.h
+ * desc: Computes the persistence pairs of a filtration over Z2 with the standard column
+ *       reduction of its boundary matrix. The boundary matrix is stored as compressed sparse
+ *       columns, and the twist optimization (clearing) is used: dimensions are reduced from
+ *       high to low, and every column that becomes a pivot row is known to reduce to zero.
+ *
+ *       Columns only ever get columns of the same dimension added to them, so when compiled
+ *       with _WSSD_THREADS_ the dimensions can also be reduced in parallel. Columns are then
+ *       cleared as soon as the dimension above finds their pivot, and the columns that are
+ *       reached before that are reduced to zero instead, which gives the same pairs.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _PERSISTENCE_REDUCER_H_
+#define _PERSISTENCE_REDUCER_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Filtration.h"
+
+/**
+ * A pair of simplices (birth, death) of a filtration. Essential classes have no death simplex,
+ * in which case deathIndex is kEssential and deathValue is infinity.
+ */
+struct PersistencePair
+{
+    static const unsigned int kEssential = 0xFFFFFFFF;
+
+    int             dimension;
+    unsigned int    birthIndex;
+    unsigned int    deathIndex;
+    double          birthValue;     // Alpha value, i.e. half the function value of the simplex
+    double          deathValue;
+};
+
+template<typename T, int D>
+class PersistenceReducer
+{
+// Fields
+private:
+    bool                                    parallel;
+
+    // Boundary matrix as compressed sparse columns: the rows of column j are
+    // rows[offsets[j]], ..., rows[offsets[j+1]-1] in ascending order.
+    std::vector<std::size_t>                offsets;
+    std::vector<unsigned int>               rows;
+
+    // Columns of each dimension, in filtration order
+    std::vector<std::vector<unsigned int>>  columnsOfDimension;
+
+    // Reduced columns that are not zero, indexed by column
+    std::vector<std::vector<unsigned int>>  reduced;
+
+    // Column that has the given row as pivot, indexed by row
+    std::vector<unsigned int>               pivotColumn;
+
+    // Columns known to reduce to zero
+    std::unique_ptr<std::atomic<bool>[]>    cleared;
+
+// Constructors
+public:
+    PersistenceReducer();
+
+// Functions
+public:
+    /**
+     * Reduce the dimensions on separate threads. Only has effect when compiled with _WSSD_THREADS_.
+     */
+    void SetParallel(bool parallel) { this->parallel = parallel; }
+
+    /**
+     * Computes the persistence pairs of 'filtration', ordered by dimension and then by death,
+     * with the essential classes last.
+     * If 'includeZeroPersistence' is false, pairs with equal birth and death value are skipped.
+     */
+    void ComputePairs(const Filtration<T,D>& filtration, std::vector<PersistencePair>& retPairs, bool includeZeroPersistence = false);
+
+    /**
+     * Prints the number of pairs per dimension.
+     */
+    void PrintStats(const std::vector<PersistencePair>& pairs) const;
+
+private:
+    /**
+     * Builds the compressed sparse columns from the boundary of each simplex.
+     */
+    void BuildColumns(const Filtration<T,D>& filtration);
+
+    /**
+     * Reduces all columns of the given dimension, in filtration order.
+     */
+    void ReduceDimension(int dimension);
+
+    /**
+     * Frees all memory used by the reduction.
+     */
+    void clear();
+};
+
+#endif //_PERSISTENCE_REDUCER_H_
@@ -0,0 +1,392 @@
+/**
+ * file: PointFile.h
+ * desc: Self-describing point set file format. Unlike the raw .bin dumps of PointSetIO, the
+ *       dimension, scalar type, number of points and bounding box are stored in a header, so a
+ *       reader can find out which instantiation it needs before reading any points, and the
+ *       quadtree constructor doesn't need to compute the bounds.
+ *
+ *       Values are stored in host byte order, little-endian on x86. The file starts with a header:
+ *
+ *         char[8]   magic "WSSDPNTS"
+ *         uint32    version
+ *         uint32    dimension D, at most kMaxPointFileDimension
+ *         uint32    scalar type (see PointScalarType)
+ *         uint32    flags (see PointFileFlags)
+ *         uint64    number of points
+ *         uint64    points per chunk
+ *         uint64    offset of the first point in the file
+ *         double[D] minimum of the bounding box
+ *         double[D] maximum of the bounding box
+ *
+ *       The points follow as one contiguous array of vec<T,D>, starting at a 64-byte aligned
+ *       offset so the file can also be memory mapped. The array is written and read in chunks
+ *       of 'points per chunk' points, which readers can also use to split the work.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _POINT_FILE_H_
+#define _POINT_FILE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Morton.h"
+#include "Vec.h"
+
+static const char          kPointFileMagic[8] = {'W','S','S','D','P','N','T','S'};
+static const std::uint32_t kPointFileVersion  = 1;
+
+// Larger dimensions in a header are rejected as corrupt, before the bounding box is allocated
+static const std::uint32_t kMaxPointFileDimension = 64;
+
+enum PointScalarType
+{
+    kScalarFloat  = 0,
+    kScalarDouble = 1,
+};
+
+enum PointFileFlags
+{
+    kMortonSorted = 1,      // Points are sorted by the Morton code in their bounding box
+};
+
+template<typename T> struct PointScalarTypeOf;
+template<> struct PointScalarTypeOf<float>  { static const PointScalarType value = kScalarFloat; };
+template<> struct PointScalarTypeOf<double> { static const PointScalarType value = kScalarDouble; };
+
+/**
+ * Header of a point file.
+ */
+struct PointFileHeader
+{
+    std::uint32_t           dimension;
+    PointScalarType         scalarType;
+    std::uint32_t           flags;
+    std::uint64_t           numPoints;
+    std::uint64_t           pointsPerChunk;
+    std::uint64_t           dataOffset;
+    std::vector<double>     minPoint;
+    std::vector<double>     maxPoint;
+
+    std::size_t GetScalarSize()    const { return (scalarType == kScalarFloat ? sizeof(float) : sizeof(double)); }
+    bool        IsMortonSorted()   const { return (flags & kMortonSorted) != 0; }
+
+    /**
+     * Reads the header from 'file'. Returns false if it isn't a point file.
+     */
+    bool Read(std::istream& file)
+    {
+        char magic[8];
+        std::uint32_t version, scalar;
+
+        file.read(magic, sizeof(magic));
+        file.read((char*)&version, sizeof(version));
+        file.read((char*)&dimension, sizeof(dimension));
+        file.read((char*)&scalar, sizeof(scalar));
+        file.read((char*)&flags, sizeof(flags));
+        file.read((char*)&numPoints, sizeof(numPoints));
+        file.read((char*)&pointsPerChunk, sizeof(pointsPerChunk));
+        file.read((char*)&dataOffset, sizeof(dataOffset));
+
+        if(!file || memcmp(magic, kPointFileMagic, sizeof(magic)) != 0 || version != kPointFileVersion ||
+            dimension == 0 || dimension > kMaxPointFileDimension || scalar > kScalarDouble || pointsPerChunk == 0)
+        {
+            return false;
+        }
+        scalarType = PointScalarType(scalar);
+
+        minPoint.resize(dimension);
+        maxPoint.resize(dimension);
+        file.read((char*)&minPoint[0], dimension*sizeof(double));
+        file.read((char*)&maxPoint[0], dimension*sizeof(double));
+
+        return !file.fail();
+    }
+
+    /**
+     * Reads the header of the file 'strFilename'. Returns false if it isn't a point file.
+     */
+    bool Read(const std::string& strFilename)
+    {
+        std::ifstream file(strFilename.c_str(), std::ios::in | std::ios::binary);
+        return file.is_open() && Read(file);
+    }
+
+    /**
+     * Returns if the file 'strFilename' starts with the magic of a point file, so a file that
+     * Read rejects can be told apart from a raw point set.
+     */
+    static bool HasMagic(const std::string& strFilename)
+    {
+        std::ifstream file(strFilename.c_str(), std::ios::in | std::ios::binary);
+        char magic[8];
+        return file.read(magic, sizeof(magic)) && memcmp(magic, kPointFileMagic, sizeof(magic)) == 0;
+    }
+
+    void Write(std::ostream& file) const
+    {
+        std::uint32_t scalar = scalarType;
+
+        file.write(kPointFileMagic, sizeof(kPointFileMagic));
+        file.write((const char*)&kPointFileVersion, sizeof(kPointFileVersion));
+        file.write((const char*)&dimension, sizeof(dimension));
+        file.write((const char*)&scalar, sizeof(scalar));
+        file.write((const char*)&flags, sizeof(flags));
+        file.write((const char*)&numPoints, sizeof(numPoints));
+        file.write((const char*)&pointsPerChunk, sizeof(pointsPerChunk));
+        file.write((const char*)&dataOffset, sizeof(dataOffset));
+        file.write((const char*)&minPoint[0], dimension*sizeof(double));
+        file.write((const char*)&maxPoint[0], dimension*sizeof(double));
+    }
+
+    /**
+     * Number of bytes the header occupies, before padding.
+     */
+    std::uint64_t GetSize() const { return 8 + 4*4 + 3*8 + 2*dimension*sizeof(double); }
+};
+
+
+/**
+ * Class that reads and writes point sets in the self-describing format.
+ */
+template<typename T, int D>
+class PointFileIO
+{
+public:
+    static const std::uint64_t kDefaultPointsPerChunk = 1 << 16;
+
+    /**
+     * Writes the point set to disk. If 'mortonSort' is set, the points are written in Morton
+     * order, which is recorded in the header. Returns if the operation was successful.
+     */
+    bool WriteToFile(const std::string& strFilename, const std::vector<vec<T,D>>& vPoints, bool mortonSort = false,
+        std::uint64_t pointsPerChunk = kDefaultPointsPerChunk, bool bVerbose = true);
+
+    /**
+     * Reads a point set from disk. The file may store float or double coordinates, they are
+     * converted to T. Fails if the dimension of the file isn't D. Returns the bounding box from
+     * the header in 'retMin' and 'retMax'. Returns if the operation was successful.
+     */
+    bool ReadFromFile(const std::string& strFilename, std::vector<vec<T,D>>& vRetPoints, vec<T,D>& retMin, vec<T,D>& retMax,
+        bool bVerbose = true);
+
+private:
+    template<typename S>
+    bool ReadPoints(std::istream& file, const PointFileHeader& header, std::vector<vec<T,D>>& vRetPoints);
+};
+
+
+
+template<typename T, int D>
+bool PointFileIO<T,D>::WriteToFile(const std::string& strFilename, const std::vector<vec<T,D>>& vPoints, bool mortonSort,
+    std::uint64_t pointsPerChunk, bool bVerbose)
+{
+    std::ofstream file(strFilename.c_str(), std::ios::out | std::ios::binary);
+    if(!file.is_open())
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" could not be opened for writing. No points saved." << std::endl;
+        }
+        return false;
+    }
+
+    // Bounding box
+    vec<T,D> min(std::numeric_limits<T>::infinity());
+    vec<T,D> max(-std::numeric_limits<T>::infinity());
+    for(auto it = vPoints.cbegin(); it != vPoints.cend(); ++it)
+    {
+        for(int d=0; d<D; ++d)
+        {
+            min[d] = std::min(min[d], (*it)[d]);
+            max[d] = std::max(max[d], (*it)[d]);
+        }
+    }
+
+    PointFileHeader header;
+    header.dimension        = D;
+    header.scalarType       = PointScalarTypeOf<T>::value;
+    header.flags            = (mortonSort ? kMortonSorted : 0);
+    header.numPoints        = vPoints.size();
+    header.pointsPerChunk   = std::max<std::uint64_t>(1, pointsPerChunk);
+    header.dataOffset       = (header.GetSize() + 63) & ~std::uint64_t(63);
+    header.minPoint.resize(D);
+    header.maxPoint.resize(D);
+    for(int d=0; d<D; ++d)
+    {
+        header.minPoint[d] = (vPoints.empty() ? 0.0 : double(min[d]));
+        header.maxPoint[d] = (vPoints.empty() ? 0.0 : double(max[d]));
+    }
+
+    header.Write(file);
+    const char padding[64] = {};
+    file.write(padding, std::streamsize(header.dataOffset - header.GetSize()));
+
+    // Sort an index array rather than the points
+    std::vector<std::size_t> order;
+    if(mortonSort)
+    {
+        T sideLength(0);
+        for(int d=0; d<D; ++d)
+        {
+            sideLength = std::max(sideLength, T(max[d] - min[d]));
+        }
+
+        std::vector<std::pair<unsigned long long, std::size_t>> codes(vPoints.size());
+        for(std::size_t i=0; i<vPoints.size(); ++i)
+        {
+            codes[i] = std::make_pair(MortonCode(vPoints[i], min, sideLength), i);
+        }
+        std::sort(codes.begin(), codes.end());
+
+        order.resize(codes.size());
+        for(std::size_t i=0; i<codes.size(); ++i)
+        {
+            order[i] = codes[i].second;
+        }
+    }
+
+    // Write chunks
+    std::vector<vec<T,D>> chunk;
+    for(std::size_t first = 0; first < vPoints.size(); first += std::size_t(header.pointsPerChunk))
+    {
+        const std::size_t last = std::min(vPoints.size(), first + std::size_t(header.pointsPerChunk));
+        if(mortonSort)
+        {
+            chunk.clear();
+            for(std::size_t i=first; i<last; ++i)
+            {
+                chunk.push_back(vPoints[order[i]]);
+            }
+            file.write(reinterpret_cast<const char*>(&chunk[0]), std::streamsize(chunk.size()*sizeof(vec<T,D>)));
+        }
+        else
+        {
+            file.write(reinterpret_cast<const char*>(&vPoints[first]), std::streamsize((last - first)*sizeof(vec<T,D>)));
+        }
+    }
+
+    if(bVerbose)
+    {
+        std::cout << "Wrote " << vPoints.size() << " points to point file: \"" << strFilename.c_str() << "\"." << std::endl;
+    }
+    return !file.fail();
+}
+
+template<typename T, int D>
+bool PointFileIO<T,D>::ReadFromFile(const std::string& strFilename, std::vector<vec<T,D>>& vRetPoints, vec<T,D>& retMin, vec<T,D>& retMax,
+    bool bVerbose)
+{
+    vRetPoints.clear();
+
+    std::ifstream file(strFilename.c_str(), std::ios::in | std::ios::binary);
+    if(!file.is_open())
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" could not be opened for reading. No points loaded." << std::endl;
+        }
+        return false;
+    }
+
+    PointFileHeader header;
+    if(!header.Read(file))
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" is not a point file. No points loaded." << std::endl;
+        }
+        return false;
+    }
+    if(header.dimension != D)
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" has dimension " << header.dimension << " instead of " << D
+                << ". No points loaded." << std::endl;
+        }
+        return false;
+    }
+
+    for(int d=0; d<D; ++d)
+    {
+        retMin[d] = T(header.minPoint[d]);
+        retMax[d] = T(header.maxPoint[d]);
+    }
+
+    // Check the header against the file before allocating, dividing so numPoints can't wrap around
+    file.seekg(0, std::ios::end);
+    const std::uint64_t fileSize = std::uint64_t(file.tellg());
+    if(!file || header.dataOffset > fileSize ||
+        header.numPoints > (fileSize - header.dataOffset) / (D*header.GetScalarSize()))
+    {
+        if(bVerbose)
+        {
+            std::cout << "File \"" << strFilename.c_str() << "\" is smaller than its header claims. No points loaded." << std::endl;
+        }
+        return false;
+    }
+
+    file.seekg(std::streamoff(header.dataOffset), std::ios::beg);
+    bool success = (header.scalarType == kScalarFloat ? ReadPoints<float>(file, header, vRetPoints) : ReadPoints<double>(file, header, vRetPoints));
+
+    if(bVerbose)
+    {
+        if(success)
+        {
+            std::cout << "Read " << vRetPoints.size() << " points from point file: \"" << strFilename.c_str() << "\"." << std::endl;
+        }
+        else
+        {
+            std::cout << "Something went wrong while reading file: \"" << strFilename.c_str() << "\"." << std::endl;
+        }
+    }
+    return success;
+}
+
+template<typename T, int D>
+template<typename S>
+bool PointFileIO<T,D>::ReadPoints(std::istream& file, const PointFileHeader& header, std::vector<vec<T,D>>& vRetPoints)
+{
+    vRetPoints.resize(std::size_t(header.numPoints));
+
+    std::vector<S> chunk;
+    for(std::size_t first = 0; first < vRetPoints.size(); first += std::size_t(header.pointsPerChunk))
+    {
+        const std::size_t count = std::min(vRetPoints.size() - first, std::size_t(header.pointsPerChunk));
+
+        if(sizeof(S) == sizeof(T))
+        {
+            // Same scalar type, read straight into place
+            file.read(reinterpret_cast<char*>(&vRetPoints[first]), std::streamsize(count*sizeof(vec<T,D>)));
+        }
+        else
+        {
+            chunk.resize(count*D);
+            file.read(reinterpret_cast<char*>(&chunk[0]), std::streamsize(chunk.size()*sizeof(S)));
+            for(std::size_t i=0; i<count; ++i)
+            {
+                for(int d=0; d<D; ++d)
+                {
+                    vRetPoints[first + i][d] = T(chunk[i*D + d]);
+                }
+            }
+        }
+
+        if(!file)
+        {
+            vRetPoints.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif //_POINT_FILE_H_
@@ -8,9 +8,20 @@
 #ifndef _POINT_SET_IO_H_
 #define _POINT_SET_IO_H_
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
+
+#ifdef _WSSD_THREADS_
+#include <thread>
+#endif //_WSSD_THREADS_
+
+#include "MappedFile.h"
 #include "Vec.h"
 
 enum FileMode
@@ -37,9 +48,27 @@ public:
 	 * Writes point set to disk. Clears vRetPoints. Returns if the operation was successful.
 	 */
 	bool ReadFromFile(const std::string& strFilename, std::vector<vec<T,D>>& vRetPoints, FileMode mode = kBinary, bool bVerbose = true);
+
+private:
+	/**
+	 * Reads an ASCII file with D whitespace separated coordinates per line. The file is mapped and split
+	 * into chunks at line boundaries, which are parsed in parallel when compiled with _WSSD_THREADS_.
+	 */
+	bool ReadAscii(const std::string& strFilename, std::vector<vec<T,D>>& vRetPoints);
+
+	/**
+	 * Parses the lines in [begin, end) and appends the points to retPoints. Empty lines are skipped.
+	 * Returns false if a line doesn't start with D coordinates.
+	 */
+	static bool ParseAsciiChunk(const char* begin, const char* end, std::vector<vec<T,D>>& retPoints);
 };
 
 
+// Parse a single coordinate, like operator>> does for the type
+inline float  ParseCoordinate(const char* str, char** end, float)  { return strtof(str, end); }
+inline double ParseCoordinate(const char* str, char** end, double) { return strtod(str, end); }
+
+
 
 
 template< class T, int D >
@@ -64,7 +93,7 @@ bool PointSetIO<T,D>::WriteToFile(const std::string& strFilename, const std::vec
 				// For text files, write each component and add spacing
 				for( unsigned int dim = 0; dim < D; ++dim )
 				{
-					file << it->el[dim] << ' ';
+					file << (*it)[dim] << ' ';
 				}
 				file << std::endl;
 			}
@@ -101,53 +130,36 @@ bool PointSetIO<T,D>::ReadFromFile(const std::string& strFilename, std::vector<v
 	// Check if this was successful
 	if(file.is_open())
 	{
-		vec<T,D> point;
-
 		if(mode == kBinary)
 		{
 			// Get the size of the file
 			file.seekg (0, std::ios::end);
-			unsigned int size = unsigned int( file.tellg() );
+			unsigned long long size = (unsigned long long)( file.tellg() );
 			file.seekg (0, std::ios::beg);
 
 			// Compute the number of points
-			unsigned int pointSize = sizeof(vec<T,D>);
-			unsigned int numPoints = size / pointSize;
+			const std::size_t pointSize = sizeof(vec<T,D>);
+			const std::size_t numPoints = std::size_t(size / pointSize);
 
-			// Read all points
-			for(unsigned int i = 0; i < numPoints; ++i)
+			// Read all points in one go
+			if(numPoints > 0)
 			{
-				file.read(reinterpret_cast<char*>(&point), pointSize);
-				vRetPoints.push_back(point);
+				vRetPoints.resize(numPoints);
+				file.read(reinterpret_cast<char*>(&vRetPoints[0]), std::streamsize(numPoints * pointSize));
 			}
 		}
 		else // mode == kAscii
 		{
-			// Loop until eof reached
-			while(file && !file.eof())
-			{
-				// Load each component of the point
-				for( unsigned int dim = 0; dim < D; ++dim )
-				{
-					file >> point[dim];
-				}
-
-				// Add to return points
-				vRetPoints.push_back(point);
-			}
-
-			if(!file)
+			file.close();
+			if(!ReadAscii(strFilename, vRetPoints))
 			{
 				// Error while reading points
 				if(bVerbose)
 				{
 					std::cout << "Something went wrong while reading file: \"" << strFilename.c_str() << "\"." << std::endl;
 				}
-				return true;
+				return false;
 			}
-
-			// eof flag only set after first read of non-existing point, so last point was added twice.
-			//vRetPoints.pop_back();
 		}
 
 		// All points read, report and return
@@ -168,4 +180,120 @@ bool PointSetIO<T,D>::ReadFromFile(const std::string& strFilename, std::vector<v
 	}
 }
 
+template< class T, int D>
+bool PointSetIO<T,D>::ReadAscii(const std::string& strFilename, std::vector<vec<T,D>>& vRetPoints)
+{
+	MappedFile file;
+	if(!file.Open(strFilename))
+	{
+		return false;
+	}
+
+	const char* data = file.GetData();
+	const std::size_t size = std::size_t(file.GetSize());
+
+#ifdef _WSSD_THREADS_
+	const std::size_t numChunks = std::max(1u, std::thread::hardware_concurrency());
+#else
+	const std::size_t numChunks = 1;
+#endif //_WSSD_THREADS_
+
+	// Split at line boundaries: each chunk ends right after a newline, or at the end of the file
+	std::vector<const char*> bounds(numChunks + 1, data + size);
+	bounds[0] = data;
+	for(std::size_t i=1; i<numChunks; ++i)
+	{
+		const char* split = std::max(bounds[i-1], data + (size/numChunks)*i);
+		const char* newline = (split < data + size ? static_cast<const char*>(memchr(split, '\n', (data + size) - split)) : NULL);
+		bounds[i] = (newline != NULL ? newline + 1 : data + size);
+	}
+
+	std::vector<std::vector<vec<T,D>>> chunks(numChunks);
+	std::vector<char> success(numChunks, 0);
+
+#ifdef _WSSD_THREADS_
+	std::vector<std::thread> threads;
+	for(std::size_t i=1; i<numChunks; ++i)
+	{
+		threads.push_back(std::thread([&, i]()
+		{
+			success[i] = ParseAsciiChunk(bounds[i], bounds[i+1], chunks[i]);
+		}));
+	}
+#endif //_WSSD_THREADS_
+
+	success[0] = ParseAsciiChunk(bounds[0], bounds[1], chunks[0]);
+
+#ifdef _WSSD_THREADS_
+	for(auto it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+#endif //_WSSD_THREADS_
+
+	// Concatenate the chunks in order
+	std::size_t numPoints = 0;
+	for(std::size_t i=0; i<numChunks; ++i)
+	{
+		if(!success[i])
+		{
+			vRetPoints.clear();
+			return false;
+		}
+		numPoints += chunks[i].size();
+	}
+
+	vRetPoints.reserve(numPoints);
+	for(std::size_t i=0; i<numChunks; ++i)
+	{
+		vRetPoints.insert(vRetPoints.end(), chunks[i].begin(), chunks[i].end());
+		std::vector<vec<T,D>>().swap(chunks[i]);
+	}
+	return true;
+}
+
+template< class T, int D>
+bool PointSetIO<T,D>::ParseAsciiChunk(const char* begin, const char* end, std::vector<vec<T,D>>& retPoints)
+{
+	// The mapped file isn't null terminated, so each line is copied before it is parsed
+	std::string line;
+	vec<T,D> point;
+
+	while(begin < end)
+	{
+		const char* lineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+		if(lineEnd == NULL)
+		{
+			lineEnd = end;
+		}
+		line.assign(begin, lineEnd);
+		begin = (lineEnd < end ? lineEnd + 1 : end);
+
+		// Skip empty lines
+		const char* str = line.c_str();
+		while(*str != '\0' && isspace((unsigned char)(*str)))
+		{
+			++str;
+		}
+		if(*str == '\0')
+		{
+			continue;
+		}
+
+		for(int dim = 0; dim < D; ++dim)
+		{
+			char* next = NULL;
+			point[dim] = ParseCoordinate(str, &next, T());
+			if(next == str)
+			{
+				return false;
+			}
+			str = next;
+		}
+
+		retPoints.push_back(point);
+	}
+	return true;
+}
+
 #endif //_POINT_SET_IO_H_
\ No newline at end of file
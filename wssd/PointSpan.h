@@ -0,0 +1,52 @@
+/**
+ * file: PointSpan.h
+ * desc: Non-owning view of a contiguous array of points, so point sets can be passed around
+ *       without copying regardless of whether they live in a std::vector or in a mapped file.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _POINT_SPAN_H_
+#define _POINT_SPAN_H_
+
+#include <vector>
+
+#include "Vec.h"
+
+template<typename T, int D>
+class PointSpan
+{
+// Fields
+private:
+    vec<T,D>*       points;
+    std::size_t     numPoints;
+
+// Constructors
+public:
+    PointSpan()
+    : points(NULL)
+    , numPoints(0)
+    {}
+
+    PointSpan(vec<T,D>* points, std::size_t numPoints)
+    : points(points)
+    , numPoints(numPoints)
+    {}
+
+    PointSpan(std::vector<vec<T,D>>& pointSet)
+    : points(pointSet.empty() ? NULL : &pointSet[0])
+    , numPoints(pointSet.size())
+    {}
+
+// Functions
+public:
+    vec<T,D>*       begin() const { return points; }
+    vec<T,D>*       end()   const { return points + numPoints; }
+
+    vec<T,D>&       operator[](std::size_t index) const { return points[index]; }
+
+    std::size_t     size()  const { return numPoints; }
+    bool            empty() const { return numPoints == 0; }
+};
+
+#endif //_POINT_SPAN_H_
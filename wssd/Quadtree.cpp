@@ -5,6 +5,7 @@
  */
 
 #include "Quadtree.h"
+#include "Instantiations.h"
 
 /**
  * Constructs and empty quadtree node.
@@ -14,8 +15,27 @@ Quadtree<T,D>::Quadtree(Quadtree<T,D>* parent, vec<T,D> minPoint, T sideLength,
 : parent(parent)
 , minPoint(minPoint)
 , sideLength(sideLength)
+, origin(parent != NULL ? parent->origin : vec<T,D>())
 , point(p)
-, representative(NULL)
+, representative(-1)
+{
+	for(unsigned int i=0; i<Orthant<D>::Max(); ++i)
+	{
+		children[i]=NULL;
+	}
+}
+
+/**
+ * Constructs an empty root node whose cell starts at 'origin'.
+ */
+template<typename T, int D>
+Quadtree<T,D>::Quadtree(const vec<T,D>& origin, T sideLength)
+: parent(NULL)
+, minPoint()
+, sideLength(sideLength)
+, origin(origin)
+, point(NULL)
+, representative(-1)
 {
 	for(unsigned int i=0; i<Orthant<D>::Max(); ++i)
 	{
@@ -65,10 +85,12 @@ const Quadtree<T,D>* Quadtree<T,D>::FindLeafNode(const vec<T,D>* p) const
 template<typename T, int D>
 bool Quadtree<T,D>::ContainsPoint(const vec<T,D>* p) const
 {
+	vec<T,D> local = *p - origin;
+
 	bool retVal = true;
 	for(int i=0; i < D; ++i) {
-		retVal &= (minPoint[i] < (*p)[i] || minPoint[i] == T(0.0));
-		retVal &= (*p)[i] <= (minPoint[i] + sideLength);
+		retVal &= (minPoint[i] < local[i] || minPoint[i] == T(0.0));
+		retVal &= local[i] <= (minPoint[i] + sideLength);
 	}
 	return retVal;
 }
@@ -81,10 +103,16 @@ Orthant<D> Quadtree<T,D>::GetOrthant(const vec<T,D>* p) const
 {
     ASSERT_MSG(ContainsPoint(p), "The node does not contain the point for which we try to find the orthant.\n");
 
+    return GetLocalOrthant(*p - origin);
+}
+
+template<typename T, int D>
+Orthant<D> Quadtree<T,D>::GetLocalOrthant(const vec<T,D>& p) const
+{
     Orthant<D> orthant;
     for(int d=0; d<D; ++d)
     {
-        orthant.Set(d, minPoint[d] + (sideLength/T(2)) < (*p)[d]);
+        orthant.Set(d, minPoint[d] + (sideLength/T(2)) < p[d]);
     }
 
     return orthant;
@@ -102,7 +130,7 @@ Orthant<D> Quadtree<T,D>::OrthantInParent() const
         return Orthant<D>();
     }
 
-    return parent->GetOrthant(&(minPoint + (sideLength/T(2))));
+    return parent->GetLocalOrthant(minPoint + (sideLength/T(2)));
 }
 
 
@@ -207,4 +235,5 @@ void Quadtree<T,D>::UpdateAllPoints()
 }
 #endif //_WSSD_VALIDATION_
 
-template class Quadtree<double,2>;
\ No newline at end of file
+#define INSTANTIATE_QUADTREE(T,D) template class Quadtree<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_QUADTREE)
\ No newline at end of file
@@ -1,7 +1,8 @@
 /**
  * file: Quadtree.h
- * desc: Compressed quadtree implementation. It is assumed that the input set consists of points
- *       in [0, 2^L -1)^d for some L.
+ * desc: Compressed quadtree implementation. The cells are stored relative to an origin, so that
+ *       in cell coordinates the input set consists of points in [0, 2^L -1)^d for some L. The
+ *       points themselves are not translated: functions that take a point subtract the origin.
  *
  *       The paper also assumes that no 2 points fall in a unit grid cell, we don't make this
  *       assumption in the code.
@@ -64,11 +65,12 @@ private:
 	Quadtree*	        children[1<<D];  // [OS] this implementation becomes infeasible quickly for high dimensions.
     vec<T,D>*			point;
 
-	const vec<T,D>		minPoint;
+	const vec<T,D>		minPoint;        // Relative to 'origin'
 	const T				sideLength;
+    const vec<T,D>      origin;          // Minimum of the input, the same for all nodes
     AxisAlignedBoundingBox<T,D> aabb;
 
-    Quadtree*           representative;
+    int                 representative;  // Id of the filtration vertex that represents this node, -1 if none.
 
 #ifdef _WSSD_VALIDATION_
 public:
@@ -78,6 +80,7 @@ public:
 public:
 	// Constructors
 						Quadtree(Quadtree* parent, vec<T,D> minPoint, T sideLength, vec<T,D>* p = NULL);
+                        Quadtree(const vec<T,D>& origin, T sideLength);
 						~Quadtree();
 
 	// Functions
@@ -96,6 +99,7 @@ public:
     Quadtree*           GetParent() const { return parent; }
     vec<T,D>*           GetPoint() const { return point; }
     const vec<T,D>&     GetMinPoint() const { return minPoint; }
+    const vec<T,D>&     GetOrigin() const { return origin; }
     const T&            GetSideLength() const { return sideLength; }
     const AxisAlignedBoundingBox<T,D>& GetAabb() const { return aabb; }
 
@@ -106,12 +110,18 @@ public:
     ConstChildIterator  CChildBegin() const { return ConstChildIterator(this, 0); }
     ConstChildIterator  CChildEnd()   const { return ConstChildIterator(this, Orthant<D>::Max()); }
 
-    Quadtree*           GetRepresentative() const { return representative; }
-    void                SetRepresentative(Quadtree* node) { representative = node; }
+    int                 GetRepresentative() const { return representative; }
+    void                SetRepresentative(int vertexId) { representative = vertexId; }
 
 #ifdef _WSSD_VALIDATION_
     void                UpdateAllPoints();
 #endif //_WSSD_VALIDATION_
+
+private:
+    /**
+     * Returns the orthant of a point given in cell coordinates.
+     */
+    Orthant<D>          GetLocalOrthant(const vec<T,D>& p) const;
 };
 
 #endif //_QUADTREE_H_
@@ -10,21 +10,41 @@
 #include "Quadtree.h"
 
 #include "QuadtreeConstructor.h"
+#include "Instantiations.h"
 
 template<typename T, int D>
 Quadtree<T,D>* QuadtreeConstructor<T,D>::ConstructQuadtree(std::vector<vec<T,D>>& pointSet)
 {
-    T sideLength(0);
-    PreparePointSet(pointSet, sideLength);
+    return ConstructQuadtree(PointSpan<T,D>(pointSet));
+}
+
+template<typename T, int D>
+Quadtree<T,D>* QuadtreeConstructor<T,D>::ConstructQuadtree(PointSpan<T,D> pointSet)
+{
+    vec<T,D> min(std::numeric_limits<T>::infinity());
+    vec<T,D> max(-std::numeric_limits<T>::infinity());
+    for(auto it = pointSet.begin(); it != pointSet.end(); ++it)
+    {
+        min.MinExtend(*it);
+        max.MaxExtend(*it);
+    }
+
+    return ConstructQuadtree(pointSet, min, max);
+}
+
+template<typename T, int D>
+Quadtree<T,D>* QuadtreeConstructor<T,D>::ConstructQuadtree(PointSpan<T,D> pointSet, const vec<T,D>& minPoint, const vec<T,D>& maxPoint)
+{
+    T sideLength = GetRootSideLength(minPoint, maxPoint);
 
     std::cout << sideLength << std::endl;
 
-    Quadtree<T,D>* root = new Quadtree<T,D>(NULL, vec<T,D>(), sideLength);
+    Quadtree<T,D>* root = new Quadtree<T,D>(minPoint, sideLength);
     
     // Insert all points
-    for(std::vector<vec<T,D>>::iterator it = pointSet.begin(); it != pointSet.end(); ++it)
+    for(vec<T,D>* it = pointSet.begin(); it != pointSet.end(); ++it)
     {
-        Insert(root, &(*it));
+        Insert(root, it);
     }
 
     // Note: We don't compress at this point
@@ -44,7 +64,7 @@ void QuadtreeConstructor<T,D>::CompressQuadtree(Quadtree<T,D>* root) const
     if( numChildren == 1 && root->parent != NULL )
     {
         Quadtree<T,D>* parent = root->parent;
-        Orthant<D> orthant = parent->GetOrthant(&(root->minPoint + (root->sideLength/T(2))));
+        Orthant<D> orthant = root->OrthantInParent();
         
         while( numChildren == 1 )
         {
@@ -122,28 +142,17 @@ void QuadtreeConstructor<T,D>::Insert(Quadtree<T,D>* root, vec<T,D>* point) cons
 };
 
 template<typename T, int D>
-void QuadtreeConstructor<T,D>::PreparePointSet(std::vector<vec<T,D>>& retPointSet, T& retSideLength)
+T QuadtreeConstructor<T,D>::GetRootSideLength(const vec<T,D>& minPoint, const vec<T,D>& maxPoint) const
 {
-    vec<T,D> min(std::numeric_limits<T>::infinity());
-    vec<T,D> max(-std::numeric_limits<T>::infinity());
-    for(auto it = retPointSet.begin(); it != retPointSet.end(); ++it)
-    {
-        min.MinExtend(*it);
-        max.MaxExtend(*it);
-    }
-
-    for(auto it = retPointSet.begin(); it != retPointSet.end(); ++it)
-    {
-        *it -= min;
-    }
-
-    max -= min;
+    vec<T,D> max = maxPoint - minPoint;
 
-    retSideLength = 0;
+    T sideLength = 0;
     for(int i=0;i<D; ++i)
     {
-        retSideLength = std::max(retSideLength, max[i]);
+        sideLength = std::max(sideLength, max[i]);
     }
+    return sideLength;
 }
 
-template class QuadtreeConstructor<double,2>;
\ No newline at end of file
+#define INSTANTIATE_QUADTREE_CONSTRUCTOR(T,D) template class QuadtreeConstructor<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_QUADTREE_CONSTRUCTOR)
\ No newline at end of file
@@ -10,6 +10,8 @@
 #ifndef _QUADTREE_CONSTRUCTOR_H_
 #define _QUADTREE_CONSTRUCTOR_H_
 
+#include "PointSpan.h"
+
 // Forward class declarations
 template<typename T, int D>
 class Quadtree;
@@ -19,8 +21,8 @@ class QuadtreeConstructor
 {
 public:
 	/**
-	 * Construct a quadtree from the given point set. The point set
-	 * is assumed to consist of point in [0, 2^L-1)^D for some L.
+	 * Construct a quadtree from the given point set. The points are not modified: the root
+	 * cell starts at the minimum of the bounding box rather than at the origin.
 	 *
 	 * This implementation runs in O(n log S) where S is the spread.
      *
@@ -28,6 +30,18 @@ public:
 	 */
 	Quadtree<T,D>* ConstructQuadtree(std::vector<vec<T,D>>& pointSet) ;
 
+    /**
+     * Same as above, for points that are not stored in a vector, e.g. a MappedPointSet. The
+     * quadtree points into 'pointSet', so it should outlive the quadtree.
+     */
+    Quadtree<T,D>* ConstructQuadtree(PointSpan<T,D> pointSet);
+
+    /**
+     * Same as above, with the bounding box of 'pointSet' already known, e.g. from the header
+     * of a PointFile. Saves a pass over the points.
+     */
+    Quadtree<T,D>* ConstructQuadtree(PointSpan<T,D> pointSet, const vec<T,D>& minPoint, const vec<T,D>& maxPoint);
+
 	/**
 	 * Compress the quadtree at root to get a linear sized tree.
 	 */
@@ -41,9 +55,9 @@ private:
 	void Insert(Quadtree<T,D>* root, vec<T,D>* point) const;
 
     /**
-     * Prepares a point set to lie in [0, 2^L-1)^D for some L.
+     * Side length of the root cell at 'minPoint' that contains the bounding box [minPoint, maxPoint].
      */
-    void PreparePointSet(std::vector<vec<T,D>>& retPointSet, T& retSideLength);
+    T GetRootSideLength(const vec<T,D>& minPoint, const vec<T,D>& maxPoint) const;
 };
 
 #endif //_QUADTREE_CONSTRUCTOR_H_
@@ -7,6 +7,7 @@
 #include "Quadtree.h"
 
 #include "QuadtreeStats.h"
+#include "Instantiations.h"
 
 template<typename T,int D>
 void QuadtreeStats<T,D>::PrintStats(const Quadtree<T,D>* root) const
@@ -67,4 +68,5 @@ void QuadtreeStats<T,D>::GetDepthStats(const Quadtree<T,D>* node, int& depth, in
     }
 }
 
-template class QuadtreeStats<double,2>;
\ No newline at end of file
+#define INSTANTIATE_QUADTREE_STATS(T,D) template class QuadtreeStats<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_QUADTREE_STATS)
\ No newline at end of file
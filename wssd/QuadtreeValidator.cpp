@@ -7,17 +7,18 @@
 #include "Quadtree.h"
 
 #include "QuadtreeValidator.h"
+#include "Instantiations.h"
 
 template<typename T, int D>
-bool QuadtreeValidator<T,D>::ValidateQuadtree(const Quadtree<T,D>* root, std::vector<vec<T,D>>& pointSet) const
+bool QuadtreeValidator<T,D>::ValidateQuadtree(const Quadtree<T,D>* root, PointSpan<T,D> pointSet) const
 {
     bool valid = true;
     printf("\nChecking quadtree validity:\n");
 
     // Check if all points can be found
-    for(std::vector<vec<T,D>>::iterator it = pointSet.begin(); it != pointSet.end(); ++it)
+    for(vec<T,D>* it = pointSet.begin(); it != pointSet.end(); ++it)
     {
-        if(!FindPoint(root, &(*it)))
+        if(!FindPoint(root, it))
         {
             printf("Could not find point: %s\n", it->ToString().c_str());
             valid = false;
@@ -150,4 +151,5 @@ bool QuadtreeValidator<T,D>::ValidateNodeContainment(const Quadtree<T,D>* node)
     return retVal;
 }
 
-template class QuadtreeValidator<double,2>;
\ No newline at end of file
+#define INSTANTIATE_QUADTREE_VALIDATOR(T,D) template class QuadtreeValidator<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_QUADTREE_VALIDATOR)
\ No newline at end of file
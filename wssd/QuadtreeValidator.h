@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "Vec.h"
+#include "PointSpan.h"
 
 // Forward class declarations
 template<typename T, int D>
@@ -24,7 +25,7 @@ public:
 	/**
 	 * Validates that the given compressed quadtree on the point set is correct. Used for debugging purposes.
 	 */
-	bool ValidateQuadtree(const Quadtree<T,D>* root, std::vector<vec<T,D>>& pointSet) const;
+	bool ValidateQuadtree(const Quadtree<T,D>* root, PointSpan<T,D> pointSet) const;
 
     /**
      * Returns true if the point is found in the quadtree.
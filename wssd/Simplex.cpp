@@ -9,6 +9,7 @@
 
 #include "Assert.h"
 #include "Simplex.h"
+#include "Instantiations.h"
 
 template<typename T, int D>
 Simplex<T,D>::Simplex(Quadtree<T,D>* vertex, unsigned int index = -1, double functionValue = -1.0)
@@ -16,6 +17,7 @@ Simplex<T,D>::Simplex(Quadtree<T,D>* vertex, unsigned int index = -1, double fun
 , functionValue(functionValue)
 , vertices(1)
 , collapsed(false)
+, visitEpoch(0)
 , fromCollapse(false)
 {
     vertices[0] = vertex;
@@ -27,11 +29,10 @@ Simplex<T,D>::Simplex(const std::vector<Quadtree<T,D>*>& verts, unsigned int ind
 : index(index)
 , functionValue(functionValue)
 , collapsed(false)
+, visitEpoch(0)
 , fromCollapse(false)
 {
-    vertices.insert(vertices.end(), verts.begin(), verts.end());
-    std::sort(vertices.begin(), vertices.end());
-	K = vertices.size() - 1;
+    Assign(verts);
 }
 
 template<typename T, int D>
@@ -39,20 +40,45 @@ Simplex<T,D>::Simplex(const Simplex<T,D>& ref, Quadtree<T,D>* newVertex, Quadtre
 : index(index)
 , functionValue(functionValue)
 , collapsed(false)
+, visitEpoch(0)
 , fromCollapse(false)
 {
-    std::set<Quadtree<T,D>*> verts;
-    verts.insert(ref.vertices.begin(), ref.vertices.end());
-    if(oldVertex)
+    Assign(ref, newVertex, oldVertex);
+}
+
+template<typename T, int D>
+void Simplex<T,D>::Assign(const Simplex<T,D>& ref, Quadtree<T,D>* newVertex, Quadtree<T,D>* oldVertex)
+{
+    ASSERT(this != &ref);
+
+    // The vertices of 'ref' are sorted and unique, so merging in 'newVertex' keeps them that way
+    vertices.clear();
+    bool inserted = (newVertex == NULL);
+    for(auto it = ref.vertices.cbegin(); it != ref.vertices.cend(); ++it)
     {
-        verts.erase(oldVertex);
+        if(!inserted && newVertex <= *it)
+        {
+            vertices.push_back(newVertex);
+            inserted = true;
+        }
+        if(*it != oldVertex && *it != newVertex)
+        {
+            vertices.push_back(*it);
+        }
     }
-    if(newVertex)
+    if(!inserted)
     {
-        verts.insert(newVertex);
+        vertices.push_back(newVertex);
     }
-	vertices.insert(vertices.end(), verts.begin(), verts.end());
-	K = vertices.size() - 1;
+	K = int(vertices.size()) - 1;
+}
+
+template<typename T, int D>
+void Simplex<T,D>::Assign(const std::vector<Quadtree<T,D>*>& verts)
+{
+    vertices.assign(verts.begin(), verts.end());
+    std::sort(vertices.begin(), vertices.end());
+	K = int(vertices.size()) - 1;
 }
 
 template<typename T, int D>
@@ -104,6 +130,25 @@ void Simplex<T,D>::AddParent(Simplex<T,D>* parent)
     parents.insert(parent);
 }
 
+template<typename T, int D>
+void Simplex<T,D>::GetStar(unsigned int epoch, std::vector<Simplex<T,D>*>& retStar, std::vector<Simplex<T,D>*>& stack)
+{
+    stack.clear();
+    stack.push_back(this);
+
+    while(!stack.empty())
+    {
+        Simplex<T,D>* simplex = stack.back();
+        stack.pop_back();
+
+        if(!simplex->collapsed && simplex->Visit(epoch))
+        {
+            retStar.push_back(simplex);
+            stack.insert(stack.end(), simplex->parents.begin(), simplex->parents.end());
+        }
+    }
+}
+
 template<typename T, int D>
 void Simplex<T,D>::GetStar(std::set<Simplex<T,D>*, typename Simplex::Comparator>& star)
 {
@@ -119,4 +164,5 @@ void Simplex<T,D>::GetStar(std::set<Simplex<T,D>*, typename Simplex::Comparator>
 }
 
 
-template class Simplex<double,2>;
\ No newline at end of file
+#define INSTANTIATE_SIMPLEX(T,D) template class Simplex<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_SIMPLEX)
\ No newline at end of file
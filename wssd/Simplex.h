@@ -41,6 +41,8 @@ private:
 
 	int							K;
 
+    unsigned int                visitEpoch;  // Last traversal that visited this simplex
+
 public:
     bool                        fromCollapse;
 
@@ -62,6 +64,17 @@ public:
      */
     Simplex(const Simplex<T,D>& ref, Quadtree<T,D>* newVertex, Quadtree<T,D>* oldVertex, int index = -1, double functionValue = -1);
 
+    /**
+     * Overwrite the vertices with those of 'ref', adding 'newVertex' and deleting 'oldVertex' like the constructor
+     * above. Reuses the vertex storage, so a single probe simplex can be used for many lookups without allocating.
+     */
+    void            Assign(const Simplex<T,D>& ref, Quadtree<T,D>* newVertex, Quadtree<T,D>* oldVertex);
+
+    /**
+     * Overwrite the vertices with 'vertices', sorted like the constructor above. Reuses the vertex storage.
+     */
+    void            Assign(const std::vector<Quadtree<T,D>*>& vertices);
+
 // Operators
 public:
     Quadtree<T,D>*& operator[](unsigned int index) { return vertices[index]; }
@@ -80,6 +93,17 @@ public:
     bool            Contains(Quadtree<T,D>* node) const { for(auto it = vertices.cbegin(); it != vertices.cend(); ++it) { if ((*it) == node ) return true; } return false; }
 
     void            GetStar(std::set<Simplex<T,D>*, typename Simplex::Comparator>& star);
+
+    /**
+     * Appends the simplices in the star that were not visited in traversal 'epoch' to 'retStar', and marks them as
+     * visited. Iterative, 'stack' is scratch space that can be reused between calls.
+     */
+    void            GetStar(unsigned int epoch, std::vector<Simplex<T,D>*>& retStar, std::vector<Simplex<T,D>*>& stack);
+
+    /**
+     * Marks the simplex as visited in traversal 'epoch'. Returns false if it already was.
+     */
+    bool            Visit(unsigned int epoch) { if(visitEpoch == epoch) return false; visitEpoch = epoch; return true; }
     void            AddParent(Simplex<T,D>* parent);
 
     //void            SetBoundary(const std::vector<Simplex<T,D>*>& b) { boundary = b; ASSERT(boundary.size() == vertices.size());}
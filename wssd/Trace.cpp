@@ -0,0 +1,166 @@
+/**
+ * file: Trace.cpp
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "Trace.h"
+
+/**
+ * Writes 'str' as a JSON string.
+ */
+static void WriteJsonString(std::ostream& out, const char* str)
+{
+    out << '"';
+    for(; *str != '\0'; ++str)
+    {
+        if(*str == '"' || *str == '\\')
+        {
+            out << '\\';
+        }
+        out << *str;
+    }
+    out << '"';
+}
+
+TraceBuffer::TraceBuffer(int threadIndex, std::size_t capacity)
+: threadIndex(threadIndex)
+, capacity(std::max<std::size_t>(1, capacity))
+, next(0)
+, numDropped(0)
+{}
+
+void TraceBuffer::AddSpan(const char* name, double beginUs, double endUs, long long arg)
+{
+    Span* span;
+    if(spans.size() < capacity)
+    {
+        spans.push_back(Span());
+        span = &spans.back();
+    }
+    else
+    {
+        // Full, overwrite the oldest span
+        span = &spans[next];
+        next = (next + 1) % capacity;
+        ++numDropped;
+    }
+
+    int i = 0;
+    for(; i < kMaxNameLength - 1 && name[i] != '\0'; ++i)
+    {
+        span->name[i] = name[i];
+    }
+    span->name[i] = '\0';
+
+    span->beginUs = beginUs;
+    span->durationUs = endUs - beginUs;
+    span->arg = arg;
+}
+
+void TraceBuffer::GetSpans(std::vector<Span>& retSpans) const
+{
+    retSpans.clear();
+    retSpans.insert(retSpans.end(), spans.begin() + next, spans.end());
+    retSpans.insert(retSpans.end(), spans.begin(), spans.begin() + next);
+}
+
+Tracer::Tracer(std::size_t spansPerThread)
+: start(std::chrono::steady_clock::now())
+, spansPerThread(spansPerThread)
+{
+    // The creating thread is the first
+    GetThreadBuffer();
+}
+
+Tracer::~Tracer()
+{
+    for(auto it = buffers.begin(); it != buffers.end(); ++it)
+    {
+        delete *it;
+    }
+}
+
+TraceBuffer* Tracer::GetThreadBuffer()
+{
+#ifdef _WSSD_THREADS_
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    // Ids of finished threads can be reused, those threads then share a buffer
+    TraceBuffer*& buffer = threadBuffers[std::this_thread::get_id()];
+    if(buffer == NULL)
+    {
+        buffer = new TraceBuffer(int(buffers.size()), spansPerThread);
+        buffers.push_back(buffer);
+    }
+    return buffer;
+#else // ~_WSSD_THREADS_
+    if(buffers.empty())
+    {
+        buffers.push_back(new TraceBuffer(0, spansPerThread));
+    }
+    return buffers[0];
+#endif //_WSSD_THREADS_
+}
+
+void Tracer::WriteChromeTrace(std::ostream& out) const
+{
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+    bool first = true;
+    std::vector<TraceBuffer::Span> spans;
+    for(auto it = buffers.cbegin(); it != buffers.cend(); ++it)
+    {
+        const int tid = (*it)->GetThreadIndex();
+
+        // Name the thread, and note if its oldest spans were dropped
+        char threadName[64];
+        if((*it)->GetNumDropped() > 0)
+            sprintf_s(threadName, "thread %d (%llu spans dropped)", tid, (*it)->GetNumDropped());
+        else if(tid == 0)
+            sprintf_s(threadName, "main");
+        else
+            sprintf_s(threadName, "thread %d", tid);
+
+        out << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid << ", \"args\": {\"name\": ";
+        WriteJsonString(out, threadName);
+        out << "}}";
+        first = false;
+
+        (*it)->GetSpans(spans);
+        for(auto span = spans.cbegin(); span != spans.cend(); ++span)
+        {
+            char times[96];
+            sprintf_s(times, "\"ts\": %.3f, \"dur\": %.3f", span->beginUs, span->durationUs);
+
+            out << ",\n{\"name\": ";
+            WriteJsonString(out, span->name);
+            out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid << ", " << times;
+            if(span->arg >= 0)
+            {
+                out << ", \"args\": {\"value\": " << span->arg << "}";
+            }
+            out << "}";
+        }
+    }
+
+    out << "\n]}\n";
+}
+
+bool Tracer::WriteChromeTrace(const std::string& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if(!file.is_open())
+    {
+        printf("File couldn't be opened. Did not save trace.\n");
+        return false;
+    }
+
+    WriteChromeTrace(file);
+    return true;
+}
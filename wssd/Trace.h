@@ -0,0 +1,161 @@
+/**
+ * file: Trace.h
+ * desc: A lightweight tracer of spans of time, to inspect how work is scheduled over the
+ *       threads. Each thread writes its spans to its own ring buffer, so apart from getting
+ *       the buffer once no locking is needed, and a long run keeps only the latest spans. The
+ *       spans are written in the Chrome trace event format, which can be opened in
+ *       chrome://tracing or Perfetto.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#ifdef _WSSD_THREADS_
+#include <map>
+#include <mutex>
+#include <thread>
+#endif //_WSSD_THREADS_
+
+/**
+ * The spans of a single thread. Once 'capacity' spans are stored, new spans overwrite the oldest.
+ */
+class TraceBuffer
+{
+// Types
+public:
+    static const int kMaxNameLength = 32;
+
+    struct Span
+    {
+        char        name[kMaxNameLength];   // Truncated if needed
+        double      beginUs;
+        double      durationUs;
+        long long   arg;                    // Negative if the span has none
+    };
+
+// Fields
+private:
+    int                 threadIndex;
+    std::size_t         capacity;
+    std::vector<Span>   spans;              // Grows up to 'capacity'
+    std::size_t         next;               // Where the next span goes once the buffer is full
+    unsigned long long  numDropped;
+
+// Constructors
+public:
+    TraceBuffer(int threadIndex, std::size_t capacity);
+
+// Functions
+public:
+    void AddSpan(const char* name, double beginUs, double endUs, long long arg);
+
+    int GetThreadIndex() const { return threadIndex; }
+    unsigned long long GetNumDropped() const { return numDropped; }
+
+    /**
+     * The stored spans from old to new.
+     */
+    void GetSpans(std::vector<Span>& retSpans) const;
+};
+
+class Tracer
+{
+// Fields
+private:
+    std::chrono::steady_clock::time_point   start;
+    std::size_t                             spansPerThread;
+    std::vector<TraceBuffer*>               buffers;
+
+#ifdef _WSSD_THREADS_
+    std::map<std::thread::id, TraceBuffer*> threadBuffers;
+    std::mutex                              buffersMutex;
+#endif //_WSSD_THREADS_
+
+// Constructors
+public:
+    Tracer(std::size_t spansPerThread = 1<<16);
+    ~Tracer();
+
+// Functions
+public:
+    /**
+     * Microseconds since the tracer was created.
+     */
+    double Now() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * The buffer of the calling thread, created on first use. Takes a lock, so threads that
+     * add many spans should get their buffer once.
+     */
+    TraceBuffer* GetThreadBuffer();
+
+    /**
+     * Writes the spans of all threads in the Chrome trace event format. Only call this while no
+     * other thread adds spans.
+     */
+    void WriteChromeTrace(std::ostream& out) const;
+
+    /**
+     * Writes the trace to a file. Returns if the operation was successful.
+     */
+    bool WriteChromeTrace(const std::string& filename) const;
+
+private:
+    Tracer(const Tracer&);
+    Tracer& operator=(const Tracer&);
+};
+
+/**
+ * Traces a span for the lifetime of the object. Does nothing if the tracer or buffer is NULL.
+ * 'name' is copied when the span ends.
+ */
+class ScopedSpan
+{
+private:
+    Tracer*         tracer;
+    TraceBuffer*    buffer;
+    const char*     name;
+    long long       arg;
+    double          beginUs;
+
+public:
+    ScopedSpan(Tracer* tracer, const char* name, long long arg = -1)
+    : tracer(tracer)
+    , buffer(tracer != NULL ? tracer->GetThreadBuffer() : NULL)
+    , name(name)
+    , arg(arg)
+    , beginUs(tracer != NULL ? tracer->Now() : 0.0)
+    {}
+
+    ScopedSpan(Tracer* tracer, TraceBuffer* buffer, const char* name, long long arg = -1)
+    : tracer(buffer != NULL ? tracer : NULL)
+    , buffer(buffer)
+    , name(name)
+    , arg(arg)
+    , beginUs(this->tracer != NULL ? tracer->Now() : 0.0)
+    {}
+
+    ~ScopedSpan()
+    {
+        if(tracer != NULL)
+        {
+            buffer->AddSpan(name, beginUs, tracer->Now(), arg);
+        }
+    }
+
+private:
+    ScopedSpan(const ScopedSpan&);
+    ScopedSpan& operator=(const ScopedSpan&);
+};
+
+#endif //_TRACE_H_
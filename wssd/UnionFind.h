@@ -0,0 +1,66 @@
+/**
+ * file: UnionFind.h
+ * desc: Disjoint set forest over the ids 0..n-1 with path compression. Used to track which
+ *       vertex of the filtration a collapsed vertex was merged into.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _UNION_FIND_H_
+#define _UNION_FIND_H_
+
+#include <vector>
+
+#include "Assert.h"
+
+class UnionFind
+{
+// Fields
+private:
+    std::vector<unsigned int> parent;
+
+// Functions
+public:
+    /**
+     * Adds a new singleton set and returns its id.
+     */
+    unsigned int Add()
+    {
+        parent.push_back((unsigned int)(parent.size()));
+        return (unsigned int)(parent.size() - 1);
+    }
+
+    /**
+     * Returns the root of the set containing 'id'. Halves the path on the way up.
+     */
+    unsigned int Find(unsigned int id)
+    {
+        ASSERT(id < parent.size());
+        while(parent[id] != id)
+        {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+    /**
+     * Merges the set of 'child' into the set of 'root'. Unlike union by rank, the root of
+     * the merged set is always the root of 'root', since it is the vertex that survives.
+     */
+    void Union(unsigned int child, unsigned int root)
+    {
+        child = Find(child);
+        root  = Find(root);
+        if(child != root)
+        {
+            parent[child] = root;
+        }
+    }
+
+    std::size_t Size() const { return parent.size(); }
+
+    void clear() { parent.clear(); }
+};
+
+#endif //_UNION_FIND_H_
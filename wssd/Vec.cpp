@@ -5,6 +5,8 @@
  */
 
 #include "Vec.h"
+#include "VecKernels.h"
+#include "Instantiations.h"
 
 template<typename T, int D>
 vec<T,D>& vec<T,D>::operator+=(const T& val)
@@ -52,11 +54,8 @@ vec<T,D>& vec<T,D>::operator-=(const vec<T,D>& val)
 template<typename T, int D>
 vec<T,D> vec<T,D>::operator-(const vec<T,D>& val) const
 {
-    vec<T,D> retVal(*this);
-    for(int d=0; d<D; ++d)
-    {
-        retVal.el[d] -= val[d];
-    }
+    vec<T,D> retVal;
+    VecKernels<T,D>::Sub(el, val.el, retVal.el);
     return retVal;
 }
 
@@ -74,12 +73,7 @@ vec<T,D> vec<T,D>::operator/(T val) const
 template<typename T, int D>
 double vec<T,D>::Length() const
 {
-    double length=0.0;
-    for(int d=0; d<D; ++d)
-    {
-        length += (el[d]*el[d]);
-    }
-    return sqrt(length);
+    return sqrt(VecKernels<T,D>::SquaredLength(el));
 }
 
 template<typename T, int D>
@@ -87,10 +81,7 @@ vec<T,D> vec<T,D>::Clamped(const vec<T,D>& min, T range) const
 {
     ASSERT(range >= T(0));
     vec<T,D> retVal;
-    for(int d=0; d<D; ++d)
-    {
-        retVal[d] = std::min(std::max(el[d], min[d]), min[d]+range);
-    }
+    VecKernels<T,D>::Clamp(el, min.el, (min + range).el, retVal.el);
     return retVal;
 }
 
@@ -98,10 +89,10 @@ template<typename T, int D>
 vec<T,D> vec<T,D>::Clamped(const vec<T,D>& min, const vec<T,D>& max) const
 {
     vec<T,D> retVal;
+    VecKernels<T,D>::Clamp(el, min.el, max.el, retVal.el);
     for(int d=0; d<D; ++d)
     {
         ASSERT(min[d]<=max[d]);
-        retVal[d] = std::min(std::max(el[d], min[d]), max[d]);
         ASSERT(min[d] <= retVal[d] && retVal[d] <= max[d]);
     }
     return retVal;
@@ -110,19 +101,13 @@ vec<T,D> vec<T,D>::Clamped(const vec<T,D>& min, const vec<T,D>& max) const
 template<typename T, int D>
 void vec<T,D>::MinExtend(const vec<T,D>& v)
 {
-    for(int d=0; d<D; ++d)
-    {
-        el[d] = std::min(el[d], v[d]);
-    }
+    VecKernels<T,D>::Min(el, v.el, el);
 }
 
 template<typename T, int D>
 void vec<T,D>::MaxExtend(const vec<T,D>& v)
 {
-    for(int d=0; d<D; ++d)
-    {
-        el[d] = std::max(el[d], v[d]);
-    }
+    VecKernels<T,D>::Max(el, v.el, el);
 }
 
 template<typename T, int D>
@@ -140,4 +125,5 @@ std::string vec<T,D>::ToString() const
     return str;
 }
 
-template class vec<double,2>;
\ No newline at end of file
+#define INSTANTIATE_VEC(T,D) template class vec<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_VEC)
\ No newline at end of file
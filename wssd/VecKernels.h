@@ -0,0 +1,330 @@
+/**
+ * file: VecKernels.h
+ * desc: Element-wise kernels on the coordinates of D-dimensional points and boxes, used by vec
+ *       and AxisAlignedBoundingBox in every traversal. The generic kernels are scalar loops, for
+ *       float and double in 2, 3, 4 and 8 dimensions they are specialized with SSE2, which x64 and
+ *       the x86 default of VS2012 (/arch:SSE2) target, or AVX when the compiler targets it
+ *       (/arch:AVX, -mavx). Define _WSSD_NO_SIMD_ to use the scalar
+ *       loops everywhere, e.g. to compare them.
+ *
+ *       The SIMD kernels give the same results as the scalar ones, bit for bit: min and max take
+ *       their operands in the order of std::min and std::max, and squared lengths are summed one
+ *       coordinate at a time, in order, since the filtration compares them against thresholds.
+ *
+ * Copyright 2013 Okke Schrijvers
+ */
+
+#ifndef _VEC_KERNELS_H_
+#define _VEC_KERNELS_H_
+
+#include <algorithm>
+
+#if !defined(_WSSD_NO_SIMD_) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define WSSD_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define WSSD_SIMD_AVX
+#include <immintrin.h>
+#endif //__AVX__
+#endif //_WSSD_NO_SIMD_
+
+/**
+ * Scalar kernels, for any T and D.
+ */
+template<typename T, int D>
+struct ScalarVecKernels
+{
+    static void Sub(const T* a, const T* b, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = a[d] - b[d];
+    }
+
+    static void Min(const T* a, const T* b, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = std::min(a[d], b[d]);
+    }
+
+    static void Max(const T* a, const T* b, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = std::max(a[d], b[d]);
+    }
+
+    /**
+     * 'p' clamped to the box [min, max].
+     */
+    static void Clamp(const T* p, const T* min, const T* max, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = std::min(std::max(p[d], min[d]), max[d]);
+    }
+
+    /**
+     * Offset of 'p' from its closest point in the box [min, max], 0 in the dimensions where
+     * 'p' is inside.
+     */
+    static void PointGap(const T* p, const T* min, const T* max, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = p[d] - std::min(std::max(p[d], min[d]), max[d]);
+    }
+
+    /**
+     * Gap between the boxes [aMin, aMax] and [bMin, bMax] in every dimension, 0 where they
+     * overlap. At most one of the differences is positive, so no branches are needed.
+     */
+    static void BoxGap(const T* aMin, const T* aMax, const T* bMin, const T* bMax, T* ret)
+    {
+        for(int d=0; d<D; ++d) ret[d] = std::max(std::max(bMin[d] - aMax[d], aMin[d] - bMax[d]), T(0));
+    }
+
+    static double SquaredLength(const T* a)
+    {
+        double length = 0.0;
+        for(int d=0; d<D; ++d)
+        {
+            length += (a[d]*a[d]);
+        }
+        return length;
+    }
+};
+
+/**
+ * The kernels of vec and AxisAlignedBoundingBox, specialized below.
+ */
+template<typename T, int D>
+struct VecKernels : public ScalarVecKernels<T,D>
+{};
+
+
+#ifdef WSSD_SIMD_SSE2
+
+/**
+ * Operations on a SIMD register of doubles or floats. Min and Max return the first operand
+ * on ties and NaNs, like std::min and std::max.
+ */
+struct SimdOps128d
+{
+    typedef __m128d Pack;
+    static const int kLanes = 2;
+
+    static Pack Load(const double* src)             { return _mm_loadu_pd(src); }
+    static void Store(double* dst, Pack p)          { _mm_storeu_pd(dst, p); }
+    static Pack Zero()                              { return _mm_setzero_pd(); }
+    static Pack Sub(Pack a, Pack b)                 { return _mm_sub_pd(a, b); }
+    static Pack Min(Pack a, Pack b)                 { return _mm_min_pd(b, a); }
+    static Pack Max(Pack a, Pack b)                 { return _mm_max_pd(b, a); }
+};
+
+struct SimdOps128f
+{
+    typedef __m128 Pack;
+    static const int kLanes = 4;
+
+    static Pack Load(const float* src)              { return _mm_loadu_ps(src); }
+    static void Store(float* dst, Pack p)           { _mm_storeu_ps(dst, p); }
+    static Pack Zero()                              { return _mm_setzero_ps(); }
+    static Pack Sub(Pack a, Pack b)                 { return _mm_sub_ps(a, b); }
+    static Pack Min(Pack a, Pack b)                 { return _mm_min_ps(b, a); }
+    static Pack Max(Pack a, Pack b)                 { return _mm_max_ps(b, a); }
+};
+
+#ifdef WSSD_SIMD_AVX
+struct SimdOps256d
+{
+    typedef __m256d Pack;
+    static const int kLanes = 4;
+
+    static Pack Load(const double* src)             { return _mm256_loadu_pd(src); }
+    static void Store(double* dst, Pack p)          { _mm256_storeu_pd(dst, p); }
+    static Pack Zero()                              { return _mm256_setzero_pd(); }
+    static Pack Sub(Pack a, Pack b)                 { return _mm256_sub_pd(a, b); }
+    static Pack Min(Pack a, Pack b)                 { return _mm256_min_pd(b, a); }
+    static Pack Max(Pack a, Pack b)                 { return _mm256_max_pd(b, a); }
+};
+
+struct SimdOps256f
+{
+    typedef __m256 Pack;
+    static const int kLanes = 8;
+
+    static Pack Load(const float* src)              { return _mm256_loadu_ps(src); }
+    static void Store(float* dst, Pack p)           { _mm256_storeu_ps(dst, p); }
+    static Pack Zero()                              { return _mm256_setzero_ps(); }
+    static Pack Sub(Pack a, Pack b)                 { return _mm256_sub_ps(a, b); }
+    static Pack Min(Pack a, Pack b)                 { return _mm256_min_ps(b, a); }
+    static Pack Max(Pack a, Pack b)                 { return _mm256_max_ps(b, a); }
+};
+#endif //WSSD_SIMD_AVX
+
+/**
+ * The D coordinates of a point in 'kPacks' registers of 'Ops'. The default loads and stores
+ * whole registers, the specializations for D=2 and D=3 use partial ones so they never touch
+ * memory past the last coordinate. Unused lanes are 0. Pairs of floats are moved as __m128i,
+ * which may alias any type, unlike a double.
+ */
+template<typename T, int D, typename Ops>
+struct SimdVec : public Ops
+{
+    typedef T                   Scalar;
+    typedef typename Ops::Pack  Pack;
+    static const int kDimension = D;
+    static const int kPacks = D / Ops::kLanes;
+
+    static void LoadVec(const T* src, Pack* ret)
+    {
+        for(int i=0; i<kPacks; ++i) ret[i] = Ops::Load(src + i*Ops::kLanes);
+    }
+
+    static void StoreVec(const Pack* src, T* dst)
+    {
+        for(int i=0; i<kPacks; ++i) Ops::Store(dst + i*Ops::kLanes, src[i]);
+    }
+};
+
+template<>
+struct SimdVec<double,3,SimdOps128d> : public SimdOps128d
+{
+    typedef double  Scalar;
+    static const int kDimension = 3;
+    static const int kPacks = 2;
+
+    static void LoadVec(const double* src, Pack* ret)
+    {
+        ret[0] = _mm_loadu_pd(src);
+        ret[1] = _mm_load_sd(src + 2);
+    }
+
+    static void StoreVec(const Pack* src, double* dst)
+    {
+        _mm_storeu_pd(dst, src[0]);
+        _mm_store_sd(dst + 2, src[1]);
+    }
+};
+
+template<>
+struct SimdVec<float,2,SimdOps128f> : public SimdOps128f
+{
+    typedef float   Scalar;
+    static const int kDimension = 2;
+    static const int kPacks = 1;
+
+    static void LoadVec(const float* src, Pack* ret)
+    {
+        ret[0] = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+    }
+
+    static void StoreVec(const Pack* src, float* dst)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_castps_si128(src[0]));
+    }
+};
+
+template<>
+struct SimdVec<float,3,SimdOps128f> : public SimdOps128f
+{
+    typedef float   Scalar;
+    static const int kDimension = 3;
+    static const int kPacks = 1;
+
+    static void LoadVec(const float* src, Pack* ret)
+    {
+        ret[0] = _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src))), _mm_load_ss(src + 2));
+    }
+
+    static void StoreVec(const Pack* src, float* dst)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_castps_si128(src[0]));
+        _mm_store_ss(dst + 2, _mm_movehl_ps(src[0], src[0]));
+    }
+};
+
+/**
+ * The kernels of ScalarVecKernels on the registers of a SimdVec.
+ */
+template<typename V>
+struct SimdVecKernels : public ScalarVecKernels<typename V::Scalar, V::kDimension>
+{
+    typedef typename V::Scalar  T;
+    typedef typename V::Pack    Pack;
+    static const int kPacks = V::kPacks;
+
+    static void Sub(const T* a, const T* b, T* ret)
+    {
+        Pack pa[kPacks], pb[kPacks];
+        V::LoadVec(a, pa);
+        V::LoadVec(b, pb);
+        for(int i=0; i<kPacks; ++i) pa[i] = V::Sub(pa[i], pb[i]);
+        V::StoreVec(pa, ret);
+    }
+
+    static void Min(const T* a, const T* b, T* ret)
+    {
+        Pack pa[kPacks], pb[kPacks];
+        V::LoadVec(a, pa);
+        V::LoadVec(b, pb);
+        for(int i=0; i<kPacks; ++i) pa[i] = V::Min(pa[i], pb[i]);
+        V::StoreVec(pa, ret);
+    }
+
+    static void Max(const T* a, const T* b, T* ret)
+    {
+        Pack pa[kPacks], pb[kPacks];
+        V::LoadVec(a, pa);
+        V::LoadVec(b, pb);
+        for(int i=0; i<kPacks; ++i) pa[i] = V::Max(pa[i], pb[i]);
+        V::StoreVec(pa, ret);
+    }
+
+    static void Clamp(const T* p, const T* min, const T* max, T* ret)
+    {
+        Pack pp[kPacks], pmin[kPacks], pmax[kPacks];
+        V::LoadVec(p, pp);
+        V::LoadVec(min, pmin);
+        V::LoadVec(max, pmax);
+        for(int i=0; i<kPacks; ++i) pp[i] = V::Min(V::Max(pp[i], pmin[i]), pmax[i]);
+        V::StoreVec(pp, ret);
+    }
+
+    static void PointGap(const T* p, const T* min, const T* max, T* ret)
+    {
+        Pack pp[kPacks], pmin[kPacks], pmax[kPacks];
+        V::LoadVec(p, pp);
+        V::LoadVec(min, pmin);
+        V::LoadVec(max, pmax);
+        for(int i=0; i<kPacks; ++i) pp[i] = V::Sub(pp[i], V::Min(V::Max(pp[i], pmin[i]), pmax[i]));
+        V::StoreVec(pp, ret);
+    }
+
+    static void BoxGap(const T* aMin, const T* aMax, const T* bMin, const T* bMax, T* ret)
+    {
+        Pack paMin[kPacks], paMax[kPacks], pbMin[kPacks], pbMax[kPacks];
+        V::LoadVec(aMin, paMin);
+        V::LoadVec(aMax, paMax);
+        V::LoadVec(bMin, pbMin);
+        V::LoadVec(bMax, pbMax);
+        for(int i=0; i<kPacks; ++i)
+        {
+            paMin[i] = V::Max(V::Max(V::Sub(pbMin[i], paMax[i]), V::Sub(paMin[i], pbMax[i])), V::Zero());
+        }
+        V::StoreVec(paMin, ret);
+    }
+};
+
+// Two or three doubles fit in SSE registers, four and eight in AVX ones if available
+template<> struct VecKernels<double,2> : public SimdVecKernels<SimdVec<double,2,SimdOps128d>> {};
+template<> struct VecKernels<double,3> : public SimdVecKernels<SimdVec<double,3,SimdOps128d>> {};
+template<> struct VecKernels<float,2>  : public SimdVecKernels<SimdVec<float,2,SimdOps128f>> {};
+template<> struct VecKernels<float,3>  : public SimdVecKernels<SimdVec<float,3,SimdOps128f>> {};
+template<> struct VecKernels<float,4>  : public SimdVecKernels<SimdVec<float,4,SimdOps128f>> {};
+
+#ifdef WSSD_SIMD_AVX
+template<> struct VecKernels<double,4> : public SimdVecKernels<SimdVec<double,4,SimdOps256d>> {};
+template<> struct VecKernels<double,8> : public SimdVecKernels<SimdVec<double,8,SimdOps256d>> {};
+template<> struct VecKernels<float,8>  : public SimdVecKernels<SimdVec<float,8,SimdOps256f>> {};
+#else // ~WSSD_SIMD_AVX
+template<> struct VecKernels<double,4> : public SimdVecKernels<SimdVec<double,4,SimdOps128d>> {};
+template<> struct VecKernels<double,8> : public SimdVecKernels<SimdVec<double,8,SimdOps128d>> {};
+template<> struct VecKernels<float,8>  : public SimdVecKernels<SimdVec<float,8,SimdOps128f>> {};
+#endif //WSSD_SIMD_AVX
+
+#endif //WSSD_SIMD_SSE2
+
+#endif //_VEC_KERNELS_H_
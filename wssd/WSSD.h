@@ -22,7 +22,7 @@ protected:
 
 // Constructor
 public:
-    WSSD(double eta) : WSSD<T,D,1>(eta) {}
+    WSSD(double eta) : WSSD<T,D,K-1>(eta) {}
 
 // Methods
 public:
@@ -31,6 +31,7 @@ public:
     template<int KK>
     const KWSSD(T,D,KK)& GetKWssd() const { return WSSD<T,D,KK>::kWssd; }
 
+    // Clear top-down, the K-WSSD points into the (K-1)-WSSD.
     void clear() { kWssd.clear(); WSSD<T,D,K-1>::clear(); }
 };
 
@@ -7,126 +7,162 @@
 #include "Quadtree.h"
 
 #include "WellSeparatedTuple.h"
+#include "Instantiations.h"
 
 
 template<typename T, int D, int K>
 WellSeparatedTuple<T,D,K>::WellSeparatedTuple()
-: handled(false)
-, maxDiam(-1.0)
+: parent(NULL)
+, node(NULL)
+, handled(false)
+{}
+
+template<typename T, int D, int K>
+WellSeparatedTuple<T,D,K>::WellSeparatedTuple(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* u)
+: parent(&tuple)
+, node(u)
+, handled(false)
 {
-    // Initialize NULL pointers.
-    memset(&el, 0, sizeof(el));
+    // [OS] it can happen that we create degenerate tuples (in which an quadtree node appears more than once).
+    //      These cannot be discarded.
 }
 
 template<typename T, int D, int K>
-WellSeparatedTuple<T,D,K>::WellSeparatedTuple(Quadtree<T,D>* u, Quadtree<T,D>* v)
-: handled(false)
-, maxDiam(-1.0)
+void WellSeparatedTuple<T,D,K>::MidPointAndDiam(vec<T,D>& retMidPoint, double& retDiameter) const
 {
-    ASSERT_MSG(K==1, "This constructor is specialized for pairs (K=1) only.\n");
-    
-    // Store the pointers in ascending order
-    // [OS] If we're not storing the WSTs in an std::set, we don't need to store them in ascending order.
-    if(u < v)
-    {
-        el[0] = u;
-        el[1] = v;
-    }
-    else
-    {
-        el[0] = v;
-        el[1] = u;
-    }
+    // Generate the AABB for the tuple
+    AxisAlignedBoundingBox<T,D> aabb(node->GetAabb());
+    parent->ExtendAabb(aabb);
 
-    SetMaxDiam();
+    // Compute midpoint and diameter of AABB
+    retMidPoint = aabb.GetMidPoint();
+    retDiameter = aabb.GetDiameter();
 }
 
 template<typename T, int D, int K>
-WellSeparatedTuple<T,D,K>::WellSeparatedTuple(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* u)
-: handled(false)
-, maxDiam(-1.0)
+void WellSeparatedTuple<T,D,K>::ExtendAabb(AxisAlignedBoundingBox<T,D>& retAabb) const
 {
-    // [OS] If we're not storing the WSTs in an std::set, we don't need to store them in ascending order
-    // Stores the pointers in ascending order
-    int i=0;
+    retAabb.Extend(node->GetAabb());
+    parent->ExtendAabb(retAabb);
+}
+
+template<typename T, int D, int K>
+void WellSeparatedTuple<T,D,K>::GetNodes(Quadtree<T,D>* (&retNodes)[K+1]) const
+{
+    // The first K nodes come sorted from the (K-1)-WST
+    Quadtree<T,D>* parentNodes[K];
+    parent->GetNodes(parentNodes);
 
-    // Store all pointers lower than u
-    while(i<K && tuple[i] < u)
+    // Store all pointers lower than our node
+    int i=0;
+    while(i<K && parentNodes[i] < node)
     {
-        el[i] = tuple[i];
+        retNodes[i] = parentNodes[i];
         ++i;
     }
 
-    // Store u
-    el[i] = u;
-    
+    // Store our node
+    retNodes[i] = node;
+
     // Store the remaining pointers
     while(i<K)
     {
-        el[i+1] = tuple[i];
+        retNodes[i+1] = parentNodes[i];
         ++i;
     }
+}
+
+template<typename T, int D, int K>
+bool WellSeparatedTuple<T,D,K>::operator<(const WellSeparatedTuple<T,D,K>& r) const
+{
+    Quadtree<T,D>* lhsNodes[K+1];
+    Quadtree<T,D>* rhsNodes[K+1];
+    GetNodes(lhsNodes);
+    r.GetNodes(rhsNodes);
 
-    // Make sure that all pointers are in ascending order.
-    for(int i=0;i<K;++i)
+    // Compare pointers in ascending order
+    for(int i=0; i<K+1; ++i)
     {
-        // [OS] it can happen that we create degenerate tuples (in which an quadtree node appears more than once).
-        //      These cannot be discarded.
-        ASSERT(el[i] <= el[i+1]);
+        if(lhsNodes[i] < rhsNodes[i])
+        {
+            // This tuple's pointers are lower
+            return true;
+        }
+        if(lhsNodes[i] > rhsNodes[i])
+        {
+            // This tuple's pointers are higher
+            return false;
+        }
+        // The i^th pointers are equal: test i+1
     }
-    SetMaxDiam();
+
+    // Tuples are equal
+    return false;
 }
 
 template<typename T, int D, int K>
-bool WellSeparatedTuple<T,D,K>::Contains(const Quadtree<T,D>* u) const
+double WellSeparatedTuple<T,D,K>::GetMaxDiam() const
+{
+    return std::max(parent->GetMaxDiam(), node->GetAabb().GetDiameter());
+}
+
+
+template<typename T, int D>
+WellSeparatedTuple<T,D,1>::WellSeparatedTuple()
+: handled(false)
+{
+    // Initialize NULL pointers.
+    memset(&el, 0, sizeof(el));
+}
+
+template<typename T, int D>
+WellSeparatedTuple<T,D,1>::WellSeparatedTuple(Quadtree<T,D>* u, Quadtree<T,D>* v)
+: handled(false)
 {
-    //ASSERT_MSG(false, "Using this to discard tuples leads to a non-correct WSSD.\n");
-    bool retVal = false;
-    for(int i=0;i<K+1;++i)
+    // Store the pointers in ascending order
+    if(u < v)
+    {
+        el[0] = u;
+        el[1] = v;
+    }
+    else
     {
-        retVal |= (el[i]==u);
+        el[0] = v;
+        el[1] = u;
     }
-    return retVal;
 }
 
-template<typename T, int D, int K>
-void WellSeparatedTuple<T,D,K>::MidPointAndDiam(vec<T,D>& retMidPoint, double& retDiameter) const
+template<typename T, int D>
+void WellSeparatedTuple<T,D,1>::MidPointAndDiam(vec<T,D>& retMidPoint, double& retDiameter) const
 {
-    AxisAlignedBoundingBox<T,D> aabb(el[0]->GetAabb());
-    
     // Generate the AABB for the tuple
-    for(int i=1; i<K+1;++i)
-    {   
-        aabb.Extend(el[i]->GetAabb());
-    }
+    AxisAlignedBoundingBox<T,D> aabb(el[0]->GetAabb());
+    aabb.Extend(el[1]->GetAabb());
 
     // Compute midpoint and diameter of AABB
     retMidPoint = aabb.GetMidPoint();
     retDiameter = aabb.GetDiameter();
 }
 
-template<typename T, int D, int K>
-bool WellSeparatedTuple<T,D,K>::operator<(const WellSeparatedTuple<T,D,K>& r) const
+template<typename T, int D>
+void WellSeparatedTuple<T,D,1>::ExtendAabb(AxisAlignedBoundingBox<T,D>& retAabb) const
+{
+    retAabb.Extend(el[0]->GetAabb());
+    retAabb.Extend(el[1]->GetAabb());
+}
+
+template<typename T, int D>
+bool WellSeparatedTuple<T,D,1>::operator<(const WellSeparatedTuple<T,D,1>& r) const
 {
     // Compare pointers in ascending order
-    for(int i=0; i<K+1; ++i)
-    {
-        if(el[i] < r.el[i])
-        {
-            // This tuple's pointers are lower
-            return true;
-        }
-        if(el[i] > r.el[i])
-        {
-            // This tuple's pointers are higher
-            return false;
-        }
-        // The i^th pointers are equal: test i+1
-    }
+    return el[0] < r.el[0] || (el[0] == r.el[0] && el[1] < r.el[1]);
+}
 
-    // Tuples are equal
-    return false;
+template<typename T, int D>
+double WellSeparatedTuple<T,D,1>::GetMaxDiam() const
+{
+    return std::max(el[0]->GetAabb().GetDiameter(), el[1]->GetAabb().GetDiameter());
 }
 
-template class WellSeparatedTuple<double,2,1>;
-template class WellSeparatedTuple<double,2,2>;
\ No newline at end of file
+#define INSTANTIATE_WELL_SEPARATED_TUPLE(T,D) template class WellSeparatedTuple<T,D,1>; template class WellSeparatedTuple<T,D,2>;
+WSSD_INSTANTIATE(INSTANTIATE_WELL_SEPARATED_TUPLE)
@@ -2,8 +2,9 @@
  * file: WellSeparatedTuple.h
  * desc: Represents a well-separated tuple.
  *
- *       [OS] we could change the representation to a recursive one where we store
- *            one Quadtree node and a pointer to a K-1 WST.
+ *       A K-WST is stored recursively as one Quadtree node and a pointer to the (K-1)-WST
+ *       it was created from, so the size of a tuple does not grow with K. The (K-1)-WSSD
+ *       must therefore outlive the K-WSSD that was constructed from it.
  *
  * Copyright 2013 Okke Schrijvers
  */
@@ -21,46 +22,47 @@
 template<typename T, int D>
 class Quadtree;
 
+template<typename T, int D>
+class AxisAlignedBoundingBox;
+
 /**
  * Holds the k+1 elements of a (e,k)-well separated tuple.
  *
- * Pointers stored in ascending order so tuples can be stored in a set.
+ * The elements are NOT stored in ascending order. Use GetNodes to obtain them sorted.
  */
 template<typename T, int D, int K>
 class WellSeparatedTuple
 {
 // Fields
 private:
-	Quadtree<T,D>*      el[K+1];
-    bool                handled;
-    double              maxDiam;
+    const WellSeparatedTuple<T,D,K-1>*  parent;
+    Quadtree<T,D>*                      node;
+    bool                                handled;
 
 // Constructors
 public:
 	WellSeparatedTuple();
 
     /**
-     * Constructor that should only be used for K=1. No implementation is given
-     * otherwise.
-     */
-    WellSeparatedTuple(Quadtree<T,D>* u, Quadtree<T,D>* v);
-
-    /**
-     * Constructor to create a K-WST from a (K-1) tuple.
+     * Constructor to create a K-WST from a (K-1) tuple. Only a pointer to 'tuple' is
+     * stored, so it should not be moved or destroyed while this tuple is in use.
      */
     WellSeparatedTuple(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* u);
 
 // Operators
 public:
-    //Quadtree<T,D>*&   operator[](int index) { return el[index]; }
-    Quadtree<T,D>*    operator[](int index) const { return el[index]; }
+    /**
+     * Returns the index'th node. Index K is the node that was added last, lower indices
+     * are forwarded to the (K-1)-WST.
+     */
+    Quadtree<T,D>*    operator[](int index) const { return (index == K ? node : (*parent)[index]); }
 
 // Functions:
 public:
     /**
      * Returns f the tuple contains a particular quadtree node.
      */
-    bool Contains(const Quadtree<T,D>* u) const;
+    bool Contains(const Quadtree<T,D>* u) const { return node == u || parent->Contains(u); }
 
     /**
      * Get the mid point of the bounding box containing all points.
@@ -71,6 +73,16 @@ public:
      */
     void MidPointAndDiam(vec<T,D>& retMidPoint, double& retDiameter) const;
 
+    /**
+     * Extend 'retAabb' with the bounding boxes of all nodes in the tuple.
+     */
+    void ExtendAabb(AxisAlignedBoundingBox<T,D>& retAabb) const;
+
+    /**
+     * Store the K+1 nodes in ascending pointer order in 'retNodes'.
+     */
+    void GetNodes(Quadtree<T,D>* (&retNodes)[K+1]) const;
+
     /**
      * Compares pointer addresses in ascending order.
      */
@@ -79,26 +91,45 @@ public:
     void SetHandled() { handled = true; }
     bool IsHandled() const { return handled; }
 
+    /**
+     * Largest diameter of the bounding boxes of the nodes. Derived on demand from the
+     * (K-1)-WST, so cache the result if it is needed more than once.
+     */
+    double GetMaxDiam() const;
+};
 
-    double GetMaxDiam() const
-    { 
-        //if(maxDiam < 0)
-        //{
-        //    std::cout << "Wrong maxDiam!!!!" << std::endl;
-        //    exit(-1);
-        //}
-        return maxDiam;
-    }
-
+/**
+ * Base case of the recursion, a well-separated pair holds both nodes.
+ */
+template<typename T, int D>
+class WellSeparatedTuple<T,D,1>
+{
+// Fields
 private:
-    void SetMaxDiam()
-    {
-        maxDiam = 0;
-        for(int i=0; i < K+1; ++i)
-        {
-            maxDiam = std::max(maxDiam, el[i]->GetAabb().GetDiameter());
-        }
-    }
+	Quadtree<T,D>*      el[2];
+    bool                handled;
+
+// Constructors
+public:
+	WellSeparatedTuple();
+    WellSeparatedTuple(Quadtree<T,D>* u, Quadtree<T,D>* v);
+
+// Operators
+public:
+    Quadtree<T,D>*    operator[](int index) const { return el[index]; }
+
+// Functions:
+public:
+    bool Contains(const Quadtree<T,D>* u) const { return el[0] == u || el[1] == u; }
+    void MidPointAndDiam(vec<T,D>& retMidPoint, double& retDiameter) const;
+    void ExtendAabb(AxisAlignedBoundingBox<T,D>& retAabb) const;
+    void GetNodes(Quadtree<T,D>* (&retNodes)[2]) const { retNodes[0] = el[0]; retNodes[1] = el[1]; }
+    bool operator<(const WellSeparatedTuple<T,D,1>& r) const;
+
+    void SetHandled() { handled = true; }
+    bool IsHandled() const { return handled; }
+
+    double GetMaxDiam() const;
 };
 
 
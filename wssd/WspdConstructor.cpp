@@ -7,6 +7,7 @@
 #include "Quadtree.h"
 
 #include "WspdConstructor.h"
+#include "Instantiations.h"
 
 template< class T, int D >
 void WspdConstructor<T,D>::ConstructWspd(Quadtree<T,D>* quadtree, KWSSD(T,D,1)& retWspd)
@@ -18,12 +19,34 @@ void WspdConstructor<T,D>::ConstructWspd(Quadtree<T,D>* quadtree, KWSSD(T,D,1)&
 
     for(Quadtree<T,D>::ChildIterator it = quadtree->ChildBegin(); it != quadtree->ChildEnd(); ++it)
     {
-        wsPairs(quadtree, *it, retWspd);
+        wsPairs(quadtree, *it, WellSeparated(quadtree, *it), retWspd);
     }
 }
 
 template< class T, int D >
-void WspdConstructor<T,D>::wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, KWSSD(T,D,1)& retWspd)
+void WspdConstructor<T,D>::ConstructWspd(Quadtree<T,D>* quadtree, std::size_t batchSize, const BatchHandler& handler)
+{
+    ASSERT(batchSize > 0);
+
+    this->batchSize = batchSize;
+    batchHandler = handler;
+
+    KWSSD(T,D,1) batch;
+    batch.reserve(batchSize);
+    ConstructWspd(quadtree, batch);
+
+    // Pass on the remaining pairs
+    if(!batch.empty())
+    {
+        batchHandler(batch);
+    }
+
+    this->batchSize = 0;
+    batchHandler = BatchHandler();
+}
+
+template< class T, int D >
+void WspdConstructor<T,D>::wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, bool wellSeparated, KWSSD(T,D,1)& retWspd)
 {
     //detect symmetrical calls and avoid them
     if(u->GetParent() == v->GetParent() && u->OrthantInParent() > v->OrthantInParent() )
@@ -31,11 +54,11 @@ void WspdConstructor<T,D>::wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, KWSSD(T,D
         return;
     }
 
-    if(WellSeparated(u,v))
+    if(wellSeparated)
     {
         if(maxMebDiameter == std::numeric_limits<double>::infinity())
         {
-            retWspd.push_back(WellSeparatedTuple<T,D,1>(u, v));
+            AddPair(WellSeparatedTuple<T,D,1>(u, v), retWspd);
         }
         else
         {
@@ -45,7 +68,7 @@ void WspdConstructor<T,D>::wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, KWSSD(T,D
             tuple.MidPointAndDiam(mid, diam);
             if(diam < maxMebDiameter)
             {
-                retWspd.push_back(tuple);
+                AddPair(tuple, retWspd);
             }
         }
     }
@@ -56,13 +79,38 @@ void WspdConstructor<T,D>::wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, KWSSD(T,D
             std::swap(u,v);
         }
 
-        for(Quadtree<T,D>::ChildIterator it = u->ChildBegin(); it != u->ChildEnd(); ++it)
+        // Test a batch of children against v, then recurse on them in order
+        Quadtree<T,D>* children[kChildBatchSize];
+        bool separated[kChildBatchSize];
+        for(Quadtree<T,D>::ChildIterator it = u->ChildBegin(); it != u->ChildEnd(); )
         {
-            wsPairs(*it, v, retWspd);
+            int count = 0;
+            for(; it != u->ChildEnd() && count < kChildBatchSize; ++it)
+            {
+                children[count++] = *it;
+            }
+
+            WellSeparated(children, count, v, separated);
+            for(int i = 0; i < count; ++i)
+            {
+                wsPairs(children[i], v, separated[i], retWspd);
+            }
         }
     }
 }
 
+template< class T, int D >
+void WspdConstructor<T,D>::AddPair(const WellSeparatedTuple<T,D,1>& pair, KWSSD(T,D,1)& retWspd)
+{
+    retWspd.push_back(pair);
+
+    if(batchSize > 0 && retWspd.size() >= batchSize)
+    {
+        batchHandler(retWspd);
+        ASSERT(retWspd.empty());
+    }
+}
+
 /**
  * Compute the distance between the 2 quadtree boxes.
  */
@@ -81,4 +129,28 @@ bool WspdConstructor<T,D>::WellSeparated(Quadtree<T,D>* u, Quadtree<T,D>* v)
     return (maxDiam <= eta*dist);
 }
 
-template class WspdConstructor<double,2>;
\ No newline at end of file
+template< class T, int D >
+void WspdConstructor<T,D>::WellSeparated(Quadtree<T,D>* const* nodes, int count, Quadtree<T,D>* v, bool* retSeparated)
+{
+    ASSERT(count <= kChildBatchSize);
+
+    const AxisAlignedBoundingBox<T,D>* boxes[kChildBatchSize];
+    double dist[kChildBatchSize];
+    for(int i = 0; i < count; ++i)
+    {
+        boxes[i] = &nodes[i]->GetAabb();
+    }
+
+    // The distance is symmetric, so v is the box that is loaded once
+    v->GetAabb().DistancesTo(boxes, count, dist);
+
+    const double vDiam = v->GetAabb().GetDiameter();
+    for(int i = 0; i < count; ++i)
+    {
+        double maxDiam = std::max(nodes[i]->GetAabb().GetDiameter(), vDiam);
+        retSeparated[i] = (nodes[i] != v && maxDiam <= eta*dist[i]);
+    }
+}
+
+#define INSTANTIATE_WSPD_CONSTRUCTOR(T,D) template class WspdConstructor<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_WSPD_CONSTRUCTOR)
\ No newline at end of file
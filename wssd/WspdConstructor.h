@@ -8,26 +8,45 @@
 #ifndef _WSPD_CONSTRUCTOR_H_
 #define _WSPD_CONSTRUCTOR_H_
 
+#include <functional>
 #include <limits>
 
 #include "WellSeparatedTuple.h"
 
+// Forward class declarations
+template<typename T, int D>
+class KernelBenchmark;
+
 template< class T, int D >
 class WspdConstructor
 {
+public:
+    typedef std::function<void(KWSSD(T,D,1)&)> BatchHandler;
+
 private:
+    // Number of children of a node that are tested against the other node at once
+    static const int kChildBatchSize = 8;
+
     double eta;
     double maxMebDiameter;
 
+    std::size_t  batchSize;
+    BatchHandler batchHandler;
+
+    // Measures WellSeparated in isolation
+    friend class KernelBenchmark<T,D>;
+
 public:
     WspdConstructor(double eta)
         : eta(eta)
         , maxMebDiameter(std::numeric_limits<double>::infinity())
+        , batchSize(0)
     {}
 
     WspdConstructor(double eta, double maxMebDiameter)
         : eta(eta)
         , maxMebDiameter(maxMebDiameter)
+        , batchSize(0)
     {}
 
 public:
@@ -36,17 +55,35 @@ public:
 	 */
 	void ConstructWspd(Quadtree<T,D>* quadtree, KWSSD(T,D,1)& retWspd);
 
+	/**
+	 * Construct a eta-WSPD without storing all of it. Whenever 'batchSize' pairs have been
+	 * found, they are passed to 'handler', which should consume them and leave the container
+	 * empty. The last, possibly smaller, batch is passed before returning.
+	 */
+	void ConstructWspd(Quadtree<T,D>* quadtree, std::size_t batchSize, const BatchHandler& handler);
+
 private:
 
     /**
-     * Recursively find all well-separated pairs. Algorithm from Har-Peled
+     * Recursively find all well-separated pairs. Algorithm from Har-Peled. 'wellSeparated'
+     * is the result of WellSeparated(u, v), the children are tested in batches.
+     */
+    void wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, bool wellSeparated, KWSSD(T,D,1)& retWspd);
+
+    /**
+     * Store a pair, and pass the batch on when it is full.
      */
-    void wsPairs(Quadtree<T,D>* u, Quadtree<T,D>* v, KWSSD(T,D,1)& retWspd);
+    void AddPair(const WellSeparatedTuple<T,D,1>& pair, KWSSD(T,D,1)& retWspd);
 
     /**
      * Test if two nodes are well-separated. Implemented as distance between bounding boxes.
      */
 	bool WellSeparated(Quadtree<T,D>* u, Quadtree<T,D>* v);	
+
+    /**
+     * WellSeparated(nodes[i], v) of 'count' <= kChildBatchSize nodes at once, in 'retSeparated'.
+     */
+    void WellSeparated(Quadtree<T,D>* const* nodes, int count, Quadtree<T,D>* v, bool* retSeparated);
 };
 
 #endif //_WSPD_CONSTRUCTOR_H_
@@ -3,15 +3,19 @@
  *
  * Copyright 2013 Okke Schrijvers
  */
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <random>
 
+#include "AncestorIndex.h"
 #include "Quadtree.h"
 
 #include "WspdValidator.h"
+#include "Instantiations.h"
 
 template<class T, int D>
-bool WspdValidator<T,D>::ValidateWspd(const KWSSD(T,D,1)& wspd, std::vector<vec<T,D>>& pointSet) const
+bool WspdValidator<T,D>::ValidateWspd(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet) const
 {
 #ifdef _WSSD_VALIDATION_
     TestWellSeparated(wspd);
@@ -23,6 +27,20 @@ bool WspdValidator<T,D>::ValidateWspd(const KWSSD(T,D,1)& wspd, std::vector<vec<
 #endif // _WSSD_VALIDATION_
 }
 
+template<class T, int D>
+bool WspdValidator<T,D>::ValidateWspdSampled(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet, std::size_t numSamples,
+    unsigned int seed) const
+{
+#ifdef _WSSD_VALIDATION_
+    TestWellSeparated(wspd);
+
+    return TestSampledPairs(wspd, pointSet, numSamples, seed);
+#else // !_WSSD_VALIDATION_
+    printf("compile with _WSSD_VALIDATION_ to include the code needed for validation.\n");
+    return false;
+#endif // _WSSD_VALIDATION_
+}
+
 #ifdef _WSSD_VALIDATION_
 template< class T, int D >
 bool WspdValidator<T,D>::TestWellSeparated(const KWSSD(T,D,1)& wspd) const
@@ -33,7 +51,7 @@ bool WspdValidator<T,D>::TestWellSeparated(const KWSSD(T,D,1)& wspd) const
 }
 
 template< class T, int D >
-bool WspdValidator<T,D>::TestAllPairs(const KWSSD(T,D,1)& wspd, std::vector<vec<T,D>>& pointSet) const
+bool WspdValidator<T,D>::TestAllPairs(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet) const
 {
     // Get the root of the quadtree
     Quadtree<T,D>* root = const_cast<Quadtree<T,D>*>((*wspd.cbegin())[0]);
@@ -105,6 +123,144 @@ bool WspdValidator<T,D>::TestAllPairs(const KWSSD(T,D,1)& wspd, std::vector<vec<
 
     return res;
 }
+
+template< class T, int D >
+bool WspdValidator<T,D>::TestSampledPairs(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet, std::size_t numSamples,
+    unsigned int seed) const
+{
+    if(pointSet.size() < 2 || numSamples == 0)
+    {
+        std::cout << "No pairs to sample" << std::endl;
+        return true;
+    }
+    if(wspd.empty())
+    {
+        std::cout << "There were pairs missing." << std::endl;
+        return false;
+    }
+
+    const int numThreads = GetNumWorkThreads();
+
+    // Get the root of the quadtree
+    const Quadtree<T,D>* root = (*wspd.cbegin())[0];
+    while( root->GetParent() )
+    {
+        root = root->GetParent();
+    }
+
+    // Sample pairs of different points, p is side 0 and q is side 1 of the sample
+    std::vector<vec<T,D>*> points(2*numSamples);
+    {
+        std::mt19937 randomEngine(seed);
+        std::uniform_int_distribution<std::size_t> randomPoint(0, pointSet.size() - 1);
+        for(std::size_t s = 0; s < numSamples; ++s)
+        {
+            std::size_t p = randomPoint(randomEngine);
+            std::size_t q;
+            do
+            {
+                q = randomPoint(randomEngine);
+            } while(q == p);
+
+            points[2*s]   = &pointSet[p];
+            points[2*s+1] = &pointSet[q];
+        }
+    }
+
+    // Entry 2*s+side in the list of a node means it is an ancestor of that side of sample s
+    AncestorIndex<T,D> ancestors;
+    std::size_t notFound = ancestors.Build(root, points, numThreads);
+
+    // Find the samples each pair represents, by intersecting the lists of its nodes. Every thread
+    // only lists the samples it finds, so this takes space linear in the number of samples found.
+    std::vector<std::vector<std::pair<std::size_t, int>>> threadHits(numThreads);
+    ParallelFor(wspd.size(), numThreads, [&](std::size_t begin, std::size_t end, int thread)
+    {
+        std::vector<std::pair<std::size_t, int>>& hits = threadHits[thread];
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const std::vector<std::size_t>* first = ancestors.Find(wspd[i][0]);
+            const std::vector<std::size_t>* second = ancestors.Find(wspd[i][1]);
+            if(first == NULL || second == NULL)
+            {
+                continue;
+            }
+
+            const std::vector<std::size_t>& a = *first;
+            const std::vector<std::size_t>& b = *second;
+            std::size_t ia = 0;
+            std::size_t ib = 0;
+            while(ia < a.size() && ib < b.size())
+            {
+                std::size_t sample = a[ia] / 2;
+                if(sample < b[ib] / 2)
+                {
+                    ++ia;
+                }
+                else if(b[ib] / 2 < sample)
+                {
+                    ++ib;
+                }
+                else
+                {
+                    // The sides of the sample both nodes are an ancestor of
+                    int sidesA = 0;
+                    int sidesB = 0;
+                    for(; ia < a.size() && a[ia] / 2 == sample; ++ia) sidesA |= 1 << (a[ia] % 2);
+                    for(; ib < b.size() && b[ib] / 2 == sample; ++ib) sidesB |= 1 << (b[ib] % 2);
+
+                    int count = int((sidesA & 1) && (sidesB & 2)) + int((sidesA & 2) && (sidesB & 1));
+                    if(count > 0)
+                    {
+                        hits.push_back(std::make_pair(sample, count));
+                    }
+                }
+            }
+        }
+    });
+
+    // Count how often each sample is represented
+    std::vector<int> counts(numSamples, 0);
+    for(auto hits = threadHits.cbegin(); hits != threadHits.cend(); ++hits)
+    {
+        for(auto it = hits->cbegin(); it != hits->cend(); ++it)
+        {
+            counts[it->first] += it->second;
+        }
+    }
+
+    // Check if all samples appear and collect stats about how often
+    std::size_t missing = 0;
+    int excess = 0;
+    int max = 0;
+    for(std::size_t s = 0; s < numSamples; ++s)
+    {
+        int count = counts[s];
+        missing += (count == 0);
+        excess += std::max(0, count - 1);
+        max = std::max(max, count - 1);
+    }
+
+    // Print the stats.
+    if(notFound > 0)
+    {
+        printf("%u of the sampled points were not found in the quadtree.\n", (unsigned int)(notFound));
+    }
+    if(missing == 0)
+    {
+        printf("None of the %u sampled pairs missing. With 95%% confidence less than %g%% of all pairs is missing.\n",
+            (unsigned int)(numSamples), 300.0 / numSamples);
+    }
+    else
+    {
+        printf("%u of the %u sampled pairs were missing, about %g%% of all pairs.\n", (unsigned int)(missing),
+            (unsigned int)(numSamples), 100.0 * missing / numSamples);
+    }
+    printf("There were %d duplicates and the largest one was %d.\n", excess, max);
+
+    return (missing == 0 && notFound == 0);
+}
 #endif //_WSSD_VALIDATION_
 
-template class WspdValidator<double,2>;
\ No newline at end of file
+#define INSTANTIATE_WSPD_VALIDATOR(T,D) template class WspdValidator<T,D>;
+WSSD_INSTANTIATE(INSTANTIATE_WSPD_VALIDATOR)
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "Vec.h"
+#include "PointSpan.h"
 #include "WellSeparatedTuple.h"
 
 template<typename T, int D>
@@ -20,7 +21,16 @@ public:
 	/**
 	 * Validates that the given WSPD on the point set is correct. Used for debugging purposes.
 	 */
-	bool ValidateWspd(const KWSSD(T,D,1)& wspd, std::vector<vec<T,D>>& pointSet) const;
+	bool ValidateWspd(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet) const;
+
+    /**
+     * Validates the WSPD on 'numSamples' random pairs of points: each should be represented by
+     * exactly one pair of the WSPD. Takes a pass over the WSPD plus O(numSamples * depth) time,
+     * and O(numSamples * depth) space, so it scales to large point sets. If no pair is missing,
+     * with 95% confidence less than a fraction 3/numSamples of all pairs is missing.
+     */
+    bool ValidateWspdSampled(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet, std::size_t numSamples,
+        unsigned int seed = 5489u) const;
 
 private:
 
@@ -33,7 +43,15 @@ private:
     /**
      * Test if all pairs in the point set appear in the realization. Takes quadratic time and space.
      */
-    bool TestAllPairs(const KWSSD(T,D,1)& wspd, std::vector<vec<T,D>>& pointSet) const;
+    bool TestAllPairs(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet) const;
+
+    /**
+     * Test if random pairs of points appear exactly once in the realization. The pair (p,q)
+     * is represented by the pairs of ancestors of the leaves of p and q, so it is enough to
+     * index the ancestors of the sampled leaves and look up both nodes of every pair.
+     */
+    bool TestSampledPairs(const KWSSD(T,D,1)& wspd, PointSpan<T,D> pointSet, std::size_t numSamples,
+        unsigned int seed) const;
 #endif //_WSSD_VALIDATION_
 };
 
@@ -4,9 +4,13 @@
  * Copyright 2013 Okke Schrijvers
  */
 
+#include <algorithm>
+
+#include "Morton.h"
 #include "Quadtree.h"
 
 #include "WssdConstructor.h"
+#include "Instantiations.h"
 
 template<typename T, int D, int K>
 void WssdConstructor<T,D,K>::ConstructWssd(const KWSSD(T,D,K-1)& srcWssd, Quadtree<T,D>* root, KWSSD(T,D,K)& retWssd)
@@ -18,6 +22,26 @@ void WssdConstructor<T,D,K>::ConstructWssd(const KWSSD(T,D,K-1)& srcWssd, Quadtr
 
     ASSERT_MSG(D>1, "The WSSD construction is not defined for D<2.\n");
 
+    if(mortonOrder)
+    {
+        std::vector<Query> queries;
+        GetSortedQueries(srcWssd, root, queries);
+
+        // Descend the quadtree with batches of queries that are close in Morton order
+        std::vector<unsigned int> active;
+        for(std::size_t first = 0; first < queries.size(); first += kQueryBatchSize)
+        {
+            std::size_t last = std::min(queries.size(), first + kQueryBatchSize);
+            active.clear();
+            for(std::size_t i = first; i < last; ++i)
+            {
+                active.push_back((unsigned int)(i));
+            }
+            FindNewNodesBatched(queries, active, 0, active.size(), root, retWssd);
+        }
+        return;
+    }
+
     // Iterate over all tuples in the (K-1)realization
     for(KWSSD(T,D,K-1)::const_iterator it = srcWssd.cbegin(); it != srcWssd.cend(); ++it)
     {
@@ -36,13 +60,27 @@ void WssdConstructor<T,D,K>::FindNewNodes(const WellSeparatedTuple<T,D,K-1>& tup
 {
     if(node->GetAabb().GetDiameter() > maxDiameter)
     {
-        // Diameter of the node is too large, recurse on the children that are close enough
-        for(Quadtree<T,D>::ChildIterator it = node->ChildBegin(); it != node->ChildEnd(); ++it)
+        // Diameter of the node is too large, recurse on the children that are close enough.
+        // The distances of a batch of children are computed at once.
+        Quadtree<T,D>* children[kChildBatchSize];
+        const AxisAlignedBoundingBox<T,D>* boxes[kChildBatchSize];
+        double distances[kChildBatchSize];
+        for(Quadtree<T,D>::ChildIterator it = node->ChildBegin(); it != node->ChildEnd(); )
         {
-            double distance = (*it)->GetAabb().DistanceTo(center);
-            if( distance < radius)
+            int count = 0;
+            for(; it != node->ChildEnd() && count < kChildBatchSize; ++it)
             {
-                FindNewNodes(tuple, (*it), center, radius, maxDiameter, retWssd);
+                children[count] = *it;
+                boxes[count++] = &(*it)->GetAabb();
+            }
+
+            AxisAlignedBoundingBox<T,D>::DistancesTo(center, boxes, count, distances);
+            for(int i = 0; i < count; ++i)
+            {
+                if( distances[i] < radius)
+                {
+                    FindNewNodes(tuple, children[i], center, radius, maxDiameter, retWssd);
+                }
             }
         }
     }
@@ -51,26 +89,103 @@ void WssdConstructor<T,D,K>::FindNewNodes(const WellSeparatedTuple<T,D,K-1>& tup
         ASSERT(node->GetAabb().DistanceTo(center) < radius);
         ASSERT(!node->GetParent() || node->GetParent()->GetAabb().GetDiameter() > maxDiameter);
 
-        if(!tuple.Contains(node))
+        AddTuple(tuple, node, retWssd);
+    }
+}
+
+template<typename T, int D, int K>
+void WssdConstructor<T,D,K>::FindNewNodesBatched(const std::vector<Query>& queries, std::vector<unsigned int>& active,
+    std::size_t begin, std::size_t end, Quadtree<T,D>* node, KWSSD(T,D,K)& retWssd)
+{
+    double nodeDiameter = node->GetAabb().GetDiameter();
+
+    // Queries for which the node is small enough end here, the others stay in [begin, descend)
+    std::size_t descend = begin;
+    for(std::size_t i = begin; i < end; ++i)
+    {
+        const Query& query = queries[active[i]];
+        if(nodeDiameter > query.maxDiameter)
         {
-            if(maxMebDiameter == std::numeric_limits<double>::infinity())
-            {
-                retWssd.push_back(WellSeparatedTuple<T,D,K>(tuple, node));
-            }
-            else
+            active[descend++] = active[i];
+        }
+        else
+        {
+            ASSERT(node->GetAabb().DistanceTo(query.center) < query.radius);
+            AddTuple(*query.tuple, node, retWssd);
+        }
+    }
+
+    if(descend == begin)
+    {
+        return;
+    }
+
+    // Recurse on the children with the queries that are close enough
+    for(Quadtree<T,D>::ChildIterator it = node->ChildBegin(); it != node->ChildEnd(); ++it)
+    {
+        const AxisAlignedBoundingBox<T,D>& childAabb = (*it)->GetAabb();
+        std::size_t childBegin = active.size();
+        for(std::size_t i = begin; i < descend; ++i)
+        {
+            const Query& query = queries[active[i]];
+            if(childAabb.DistanceTo(query.center) < query.radius)
             {
-                WellSeparatedTuple<T,D,K> tuple(tuple, node);
-                // [OS] This should be MEB DIAMETER!!!!!
-                //vec<T,D> mid;
-                //double   diam;
-                //tuple.MidPointAndDiam(mid, diam);
-                //if(diam < maxMebDiameter)
-                //{
-                    retWssd.push_back(tuple);
-//                }
+                active.push_back(active[i]);
             }
         }
+
+        std::size_t childEnd = active.size();
+        if(childBegin != childEnd)
+        {
+            FindNewNodesBatched(queries, active, childBegin, childEnd, *it, retWssd);
+        }
+        active.resize(childBegin);
+    }
+}
+
+template<typename T, int D, int K>
+void WssdConstructor<T,D,K>::AddTuple(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* node, KWSSD(T,D,K)& retWssd)
+{
+    if(!tuple.Contains(node))
+    {
+        if(maxMebDiameter == std::numeric_limits<double>::infinity())
+        {
+            retWssd.push_back(WellSeparatedTuple<T,D,K>(tuple, node));
+        }
+        else
+        {
+            WellSeparatedTuple<T,D,K> newTuple(tuple, node);
+            // [OS] This should be MEB DIAMETER!!!!!
+            //vec<T,D> mid;
+            //double   diam;
+            //newTuple.MidPointAndDiam(mid, diam);
+            //if(diam < maxMebDiameter)
+            //{
+                retWssd.push_back(newTuple);
+//            }
+        }
     }
 }
 
-template class WssdConstructor<double,2,2>;
\ No newline at end of file
+template<typename T, int D, int K>
+void WssdConstructor<T,D,K>::GetSortedQueries(const KWSSD(T,D,K-1)& srcWssd, Quadtree<T,D>* root, std::vector<Query>& retQueries) const
+{
+    double diameter;
+    double radiusFactor = (1.0 + 1.0/double(D))/sqrt(1.0 - 1.0/double(D*D)); // [OS] in the paper this is 2
+
+    retQueries.resize(srcWssd.size());
+    for(std::size_t i = 0; i < srcWssd.size(); ++i)
+    {
+        Query& query = retQueries[i];
+        query.tuple = &srcWssd[i];
+        srcWssd[i].MidPointAndDiam(query.center, diameter);
+        query.radius = radiusFactor*(diameter/2.0);
+        query.maxDiameter = (eta/(1.0 + eta))*(diameter/2.0);
+        query.mortonCode = MortonCode(query.center - root->GetOrigin(), root->GetMinPoint(), root->GetSideLength());
+    }
+
+    std::stable_sort(retQueries.begin(), retQueries.end());
+}
+
+#define INSTANTIATE_WSSD_CONSTRUCTOR(T,D) template class WssdConstructor<T,D,2>;
+WSSD_INSTANTIATE(INSTANTIATE_WSSD_CONSTRUCTOR)
\ No newline at end of file
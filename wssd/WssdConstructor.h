@@ -17,23 +17,54 @@ template< typename T, int D, int K>
 class WssdConstructor
 {
 private:
+    /**
+     * A range query for a single (K-1)-tuple.
+     */
+    struct Query
+    {
+        const WellSeparatedTuple<T,D,K-1>*  tuple;
+        vec<T,D>                            center;
+        double                              radius;
+        double                              maxDiameter;
+        unsigned long long                  mortonCode;
+
+        bool operator<(const Query& rhs) const { return mortonCode < rhs.mortonCode; }
+    };
+
+    // Number of consecutive queries that descend the quadtree together in Morton order.
+    static const int kQueryBatchSize = 256;
+
+    // Number of children of a node whose distance to a query is computed at once
+    static const int kChildBatchSize = 8;
+
     double eta;
     double maxMebDiameter;
+    bool   mortonOrder;
 
 public:
     WssdConstructor(double eta)
     : eta(eta)
     , maxMebDiameter(std::numeric_limits<double>::infinity())
+    , mortonOrder(false)
     {}
 
     WssdConstructor(double eta, double maxMebDiameter)
     : eta(eta)
     , maxMebDiameter(maxMebDiameter)
+    , mortonOrder(false)
     {}
 
+    /**
+     * When enabled, the tuples of the (K-1)-WSSD are sorted by the Morton code of their
+     * midpoint and batches of nearby range queries traverse the quadtree together. The
+     * resulting WSSD is the same, but the order of the tuples differs.
+     */
+    void SetMortonOrder(bool enable) { mortonOrder = enable; }
+
 public:
 	/**
 	 * Construct a (eta,k)-WSSD from a (eta,k-1)-WSSD. Parameter eta should be in (0,1)
+	 * The tuples in retWssd point into srcWssd, so srcWssd should outlive retWssd.
 	 */
 	void ConstructWssd(const KWSSD(T,D,K-1)& srcWssd, Quadtree<T,D>* root, KWSSD(T,D,K)& retWssd);
 
@@ -44,6 +75,24 @@ private:
     void WssdConstructor<T,D,K>::FindNewNodes(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* node,
         const vec<T,D>& center, double diameter, double maxDiameter, KWSSD(T,D,K)& retWssd);
 
+    /**
+     * Perform the range queries queries[active[begin..end)] in a single top-down traversal.
+     * The indices of the queries that reach a child are appended to 'active' and removed
+     * again before returning.
+     */
+    void FindNewNodesBatched(const std::vector<Query>& queries, std::vector<unsigned int>& active,
+        std::size_t begin, std::size_t end, Quadtree<T,D>* node, KWSSD(T,D,K)& retWssd);
+
+    /**
+     * Add the tuple obtained by adding 'node' to 'tuple' to the WSSD, unless 'tuple' already contains it.
+     */
+    void AddTuple(const WellSeparatedTuple<T,D,K-1>& tuple, Quadtree<T,D>* node, KWSSD(T,D,K)& retWssd);
+
+    /**
+     * Build the range queries for all tuples in 'srcWssd' and sort them by Morton code.
+     */
+    void GetSortedQueries(const KWSSD(T,D,K-1)& srcWssd, Quadtree<T,D>* root, std::vector<Query>& retQueries) const;
+
 };
 
 #endif //_WSPD_CONSTRUCTOR_H_
@@ -5,6 +5,7 @@
  */
 
 #include "WssdStats.h"
+#include "Instantiations.h"
 
 template<typename T, int D, int K>
 void WssdStats<T,D,K>::PrintStats(const KWSSD(T,D,K)& wspd) const
@@ -44,5 +45,5 @@ void WssdStats<T,D,K>::PrintAlphaStats(const KWSSD(T,D,K)& wspd, int steps, doub
     }
 }
 
-template class WssdStats<double,2,1>;
-template class WssdStats<double,2,2>;
\ No newline at end of file
+#define INSTANTIATE_WSSD_STATS(T,D) template class WssdStats<T,D,1>; template class WssdStats<T,D,2>;
+WSSD_INSTANTIATE(INSTANTIATE_WSSD_STATS)
\ No newline at end of file
@@ -4,14 +4,18 @@
  * Copyright 2013 Okke Schrijvers
  */
 
+#include <algorithm>
 #include <map>
+#include <random>
 
+#include "AncestorIndex.h"
 #include "Quadtree.h"
 
 #include "WssdValidator.h"
+#include "Instantiations.h"
 
 template<typename T, int D, int K>
-bool WssdValidator<T,D,K>::ValidateWssd(const KWSSD(T,D,K)& wspd, std::vector<vec<T,D>>& pointSet) const
+bool WssdValidator<T,D,K>::ValidateWssd(const KWSSD(T,D,K)& wspd, PointSpan<T,D> pointSet) const
 {
 #ifdef _WSSD_VALIDATION_
     TestWellSeparated(wspd);
@@ -23,7 +27,60 @@ bool WssdValidator<T,D,K>::ValidateWssd(const KWSSD(T,D,K)& wspd, std::vector<ve
 #endif // _WSSD_VALIDATION_
 }
 
+template<typename T, int D, int K>
+bool WssdValidator<T,D,K>::ValidateWssdSampled(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet, std::size_t numSamples,
+    unsigned int seed) const
+{
 #ifdef _WSSD_VALIDATION_
+    TestWellSeparated(wssd);
+
+    return TestSampledTuples(wssd, pointSet, numSamples, seed);
+#else // !_WSSD_VALIDATION_
+    printf("compile with _WSSD_VALIDATION_ to include the code needed for validation.\n");
+    return false;
+#endif // _WSSD_VALIDATION_
+}
+
+#ifdef _WSSD_VALIDATION_
+/**
+ * Number of ways to assign each of 'size' nodes a different point, where masks[j] has bit i set
+ * if node j is an ancestor of point i. Size is at most D+1, so this is a small dynamic program
+ * over the subsets of assigned points.
+ */
+static int CountAssignments(const int* masks, int size)
+{
+    // ways[m] is the number of ways the first |m| nodes are assigned the points in m
+    std::vector<int> ways(std::size_t(1) << size, 0);
+    ways[0] = 1;
+    for(int m = 0; m < (1 << size); ++m)
+    {
+        if(ways[m] == 0)
+        {
+            continue;
+        }
+
+        int assigned = 0;
+        for(int i = 0; i < size; ++i)
+        {
+            assigned += (m >> i) & 1;
+        }
+        if(assigned == size)
+        {
+            continue;
+        }
+
+        int options = masks[assigned] & ~m;
+        for(int i = 0; i < size; ++i)
+        {
+            if((options >> i) & 1)
+            {
+                ways[m | (1 << i)] += ways[m];
+            }
+        }
+    }
+    return ways[(1 << size) - 1];
+}
+
 template<typename T, int D, int K>
 bool WssdValidator<T,D,K>::TestWellSeparated(const KWSSD(T,D,K)& wspd) const
 {
@@ -33,9 +90,14 @@ bool WssdValidator<T,D,K>::TestWellSeparated(const KWSSD(T,D,K)& wspd) const
 }
 
 template<class T, int D, int K>
-bool WssdValidator<T,D,K>::TestAllTuples(const KWSSD(T,D,K)& wssd, std::vector<vec<T,D>>& pointSet) const
+bool WssdValidator<T,D,K>::TestAllTuples(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet) const
 {
     ASSERT_MSG(K==2, "Only for K==2, for K==1 use WspdValidator, for K>2 write the code to validate ;). Running time is O(n^(K+1)).\n");
+    if(K != 2)
+    {
+        printf("Validating all tuples only works for K==2, use ValidateWssdSampled.\n");
+        return false;
+    }
 
     // Get the root of the quadtree
     // [OS] performing const cast since it's just for validation anyway
@@ -117,6 +179,168 @@ bool WssdValidator<T,D,K>::TestAllTuples(const KWSSD(T,D,K)& wssd, std::vector<v
 
     return res;
 }
+
+template<class T, int D, int K>
+bool WssdValidator<T,D,K>::TestSampledTuples(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet, std::size_t numSamples,
+    unsigned int seed) const
+{
+    const int size = K + 1;
+    if(pointSet.size() < std::size_t(size) || numSamples == 0)
+    {
+        printf("No tuples to sample.\n");
+        return true;
+    }
+    if(wssd.empty())
+    {
+        printf("Missing: %u.\n", (unsigned int)(numSamples));
+        return false;
+    }
+
+    const int numThreads = GetNumWorkThreads();
+
+    // Get the root of the quadtree
+    const Quadtree<T,D>* root = (*wssd.cbegin())[0];
+    while( root->GetParent() )
+    {
+        root = root->GetParent();
+    }
+
+    // Sample sets of K+1 different points, point i of sample s is at size*s+i
+    std::vector<vec<T,D>*> points(size*numSamples);
+    {
+        std::mt19937 randomEngine(seed);
+        std::uniform_int_distribution<std::size_t> randomPoint(0, pointSet.size() - 1);
+        for(std::size_t s = 0; s < numSamples; ++s)
+        {
+            vec<T,D>** sample = &points[size*s];
+            for(int i = 0; i < size; ++i)
+            {
+                do
+                {
+                    sample[i] = &pointSet[randomPoint(randomEngine)];
+                } while(std::find(sample, sample + i, sample[i]) != sample + i);
+            }
+        }
+    }
+
+    AncestorIndex<T,D> ancestors;
+    std::size_t notFound = ancestors.Build(root, points, numThreads);
+
+    // Find the samples each tuple represents. The samples below all nodes of a tuple are found
+    // by walking their lists simultaneously. Every thread only lists the samples it finds, so
+    // this takes space linear in the number of samples found.
+    std::vector<std::vector<std::pair<std::size_t, int>>> threadHits(numThreads);
+    ParallelFor(wssd.size(), numThreads, [&](std::size_t begin, std::size_t end, int thread)
+    {
+        std::vector<std::pair<std::size_t, int>>& hits = threadHits[thread];
+        const std::vector<std::size_t>* lists[K+1];
+        std::size_t pos[K+1];
+        int masks[K+1];
+
+        for(std::size_t t = begin; t < end; ++t)
+        {
+            bool found = true;
+            for(int j = 0; j < size; ++j)
+            {
+                lists[j] = ancestors.Find(wssd[t][j]);
+                found = found && (lists[j] != NULL);
+                pos[j] = 0;
+            }
+            if(!found)
+            {
+                continue;
+            }
+
+            for(;;)
+            {
+                // The first sample that could be below all nodes
+                std::size_t sample = 0;
+                bool done = false;
+                for(int j = 0; j < size && !done; ++j)
+                {
+                    done = (pos[j] == lists[j]->size());
+                    if(!done)
+                    {
+                        sample = std::max(sample, (*lists[j])[pos[j]] / size);
+                    }
+                }
+
+                bool all = true;
+                for(int j = 0; j < size && !done; ++j)
+                {
+                    const std::vector<std::size_t>& list = *lists[j];
+                    while(pos[j] < list.size() && list[pos[j]] / size < sample)
+                    {
+                        ++pos[j];
+                    }
+                    done = (pos[j] == list.size());
+                    all = all && !done && (list[pos[j]] / size == sample);
+                }
+                if(done)
+                {
+                    break;
+                }
+                if(!all)
+                {
+                    continue;
+                }
+
+                // Which points of the sample each node is an ancestor of
+                for(int j = 0; j < size; ++j)
+                {
+                    const std::vector<std::size_t>& list = *lists[j];
+                    masks[j] = 0;
+                    for(; pos[j] < list.size() && list[pos[j]] / size == sample; ++pos[j])
+                    {
+                        masks[j] |= 1 << (list[pos[j]] % size);
+                    }
+                }
+                int count = CountAssignments(masks, size);
+                if(count > 0)
+                {
+                    hits.push_back(std::make_pair(sample, count));
+                }
+            }
+        }
+    });
+
+    // Count how often each sample is represented
+    std::vector<int> counts(numSamples, 0);
+    for(auto hits = threadHits.cbegin(); hits != threadHits.cend(); ++hits)
+    {
+        for(auto it = hits->cbegin(); it != hits->cend(); ++it)
+        {
+            counts[it->first] += it->second;
+        }
+    }
+
+    // Check if all samples are accounted for
+    std::size_t missing = 0;
+    int excess = 0;
+    int max = 0;
+    for(std::size_t s = 0; s < numSamples; ++s)
+    {
+        int count = counts[s];
+        missing += (count == 0);
+        excess += std::max(0, count - 1);
+        max = std::max(max, count - 1);
+    }
+
+    // Report stats
+    if(notFound > 0)
+    {
+        printf("%u of the sampled points were not found in the quadtree.\n", (unsigned int)(notFound));
+    }
+    printf("There were %d duplicates and the largest one was %d.\n", excess, max);
+    printf("Missing: %u of %u sampled tuples.\n", (unsigned int)(missing), (unsigned int)(numSamples));
+    if(missing == 0)
+    {
+        printf("With 95%% confidence less than %g%% of all tuples is missing.\n", 300.0 / numSamples);
+    }
+
+    return (missing == 0 && notFound == 0);
+}
 #endif //_WSSD_VALIDATION_
 
-template class WssdValidator<double,2,2>;
\ No newline at end of file
+#define INSTANTIATE_WSSD_VALIDATOR(T,D) template class WssdValidator<T,D,1>; template class WssdValidator<T,D,2>;
+WSSD_INSTANTIATE(INSTANTIATE_WSSD_VALIDATOR)
\ No newline at end of file
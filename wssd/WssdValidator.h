@@ -1,6 +1,7 @@
 /**
  * file: WssdValidator.h
- * desc: Validates WSSD is correct for a point set. Only works for K=2. Space and running time is O(n^(K+1)).
+ * desc: Validates WSSD is correct for a point set. Validating all tuples only works for K=2, space and
+ *       running time is O(n^(K+1)). Validating a sample of the tuples works for any K.
  *
  * Copyright 2013 Okke Schrijvers
  */
@@ -12,6 +13,7 @@
 
 #include "WellSeparatedTuple.h"
 #include "Vec.h"
+#include "PointSpan.h"
 
 template<typename T, int D, int K>
 class WssdValidator
@@ -20,7 +22,16 @@ public:
 	/**
 	 * Validates that the given WSPD on the point set is correct. Used for debugging purposes.
 	 */
-	bool ValidateWssd(const KWSSD(T,D,K)& wssd, std::vector<vec<T,D>>& pointSet) const;
+	bool ValidateWssd(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet) const;
+
+    /**
+     * Validates the WSSD on 'numSamples' random sets of K+1 points: each should be represented by
+     * exactly one tuple of the WSSD. Takes a pass over the WSSD plus O(numSamples * K * depth)
+     * time, and O(numSamples * K * depth) space, so it scales to large point sets. If no set is
+     * missing, with 95% confidence less than a fraction 3/numSamples of all sets is missing.
+     */
+    bool ValidateWssdSampled(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet, std::size_t numSamples,
+        unsigned int seed = 5489u) const;
 
 private:
 #ifdef _WSSD_VALIDATION_
@@ -32,7 +43,14 @@ private:
     /**
      * Test if all simplices appear in the realization.
      */
-    bool TestAllTuples(const KWSSD(T,D,K)& wssd, std::vector<vec<T,D>>& pointSet) const;
+    bool TestAllTuples(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet) const;
+
+    /**
+     * Test if random sets of K+1 points appear exactly once in the realization. The nodes of
+     * every tuple are looked up in an index of the ancestors of the sampled points.
+     */
+    bool TestSampledTuples(const KWSSD(T,D,K)& wssd, PointSpan<T,D> pointSet, std::size_t numSamples,
+        unsigned int seed) const;
 #endif //_WSSD_VALIDATION_
 };
 
@@ -3,7 +3,8 @@
  * Copyright 2013 Okke Schrijvers
  */
 
-#include "PointSetIO.h"
+#include "PointFile.h"
+#include "MappedPointSet.h"
 
 #include "Quadtree.h"
 #include "QuadtreeConstructor.h"
@@ -24,35 +25,92 @@
 #include "FiltrationValidator.h"
 
 #include "Exporter.h"
+#include "PersistenceReducer.h"
+#include "Metrics.h"
+#include "PerfStats.h"
+#include "Trace.h"
+#include "Instantiations.h"
 
-int main()
+/**
+ * Runs the pipeline on a point set, with the instantiation that DispatchInstantiation picks.
+ */
+struct Pipeline
+{
+    const char* fileName;
+    bool        isPointFile;    // Self-describing PointFile, otherwise a raw .bin file of PointSetIO
+    bool        pointsRead;
+
+    Pipeline(const char* fileName, bool isPointFile)
+    : fileName(fileName)
+    , isPointFile(isPointFile)
+    , pointsRead(false)
+    {}
+
+    template<typename T, int dimension>
+    void Run();
+};
+
+template<typename T, int dimension>
+void Pipeline::Run()
 {
     // Test settings
-    const int dimension = 2;
-    typedef double T;
     const double eps = .1;
     const double eta = eps / 5.0;
     const double wspdEta = eta / 2.0;
+    const bool fusedPipeline = false;
+    const bool traceTimeline = false;   // Writes trace_<eps>.json, costs a lock per traced thread
 
     const int maxDelta = 200;
     const double maxAlpha = std::numeric_limits<double>::infinity();
     //const double maxAlpha = (1.0 + (2.0/3.0)*eps)*pow(1.0 + eps, maxDelta);
 
 
-    // Filename and point set declaration
-    //char* fileName = "D:/Downloads/equi_triangle.txt";
-    char* fileName = "../data/testcase_2_200_0.bin";
-    std::vector<vec<T,dimension>> points;
+    // Per-stage wall/cpu time and peak memory, written next to the filtration
+    Metrics metrics;
+    Tracer tracer;
+    if(traceTimeline)
+    {
+        metrics.SetTracer(&tracer);
+    }
+    metrics.SetParameter("file", fileName);
+    metrics.SetParameter("dimension", dimension);
+    metrics.SetParameter("scalar", sizeof(T) == sizeof(float) ? "float" : "double");
+    metrics.SetParameter("eps", eps);
+    metrics.SetParameter("max_delta", maxDelta);
+    metrics.SetParameter("fused", fusedPipeline ? "true" : "false");
+
+#ifdef _WSSD_PERF_COUNTERS_
+    // Hardware counters per stage, only available on Linux
+    if(!metrics.EnablePerfCounters())
+    {
+        printf("Hardware performance counters not available.\n");
+    }
+#endif //_WSSD_PERF_COUNTERS_
     
-    // Read a dataset
-	if( PointSetIO<T,dimension>().ReadFromFile(fileName, points) )
+    // Map the dataset into memory, a point file also has the bounding box. The quadtree keeps
+    // pointers into the mapping, so it stays open until the end.
+    MappedPointSet<T,dimension> mappedPoints;
+    metrics.BeginStage("load_points");
+    pointsRead = mappedPoints.Open(fileName);
+    PointSpan<T,dimension> points = mappedPoints.GetPoints();
+    metrics.AddCount("points", points.size());
+    metrics.EndStage();
+
+	if( pointsRead )
     {
         // Construct the quadtree
 		QuadtreeConstructor<T, dimension> constructor;
-		Quadtree<T, dimension>* quadtree = constructor.ConstructQuadtree(points);
+        vec<T,dimension> minPoint, maxPoint;
+        metrics.BeginStage("quadtree");
+		Quadtree<T, dimension>* quadtree = (points.size() > 0 && mappedPoints.GetBounds(minPoint, maxPoint) ?
+            constructor.ConstructQuadtree(points, minPoint, maxPoint) :
+            constructor.ConstructQuadtree(points));
+        metrics.EndStage();
 
         // Compress the quadtree
+        metrics.BeginStage("compress");
         constructor.CompressQuadtree(quadtree);
+        metrics.EndStage();
 
         // Validate quadtree
         //CompressedQuadtreeValidator<T,dimension> quadtreeValidator;
@@ -62,71 +120,172 @@ int main()
         //CompressedQuadtreeStats<T,dimension> quadtreeStats;
         //quadtreeStats.QuadtreeStats(quadtree);
 
-        WSSD<T,dimension> wssd(eta);
+        Filtration<T,dimension> filtration;
+        FiltrationConstructor<T,dimension> filtrationConstructor(eps, 0, maxDelta);
+        filtrationConstructor.SetMetrics(&metrics);
+        filtrationConstructor.SetTracer(traceTimeline ? &tracer : NULL);
 
-        // Create WSPD
         WspdConstructor<T,dimension> wpsdConstructor(wspdEta, maxAlpha);
-        wpsdConstructor.ConstructWspd(quadtree, wssd.GetKWssd<1>());
-
-        printf("Number of 1-WSSD pairs: %d\n\n", wssd.GetKWssd<1>().size());
-
-        //// Print stats of the (eta,1)-WSSD
-        //WssdStats<T,dimension,1> wspdStats;
-        //wspdStats.PrintStats(wspdTuples);
-
-        //// Validate the (eta,1)-WSSD
-        //printf("Starting (eta,1)-WSSD validation. Takes quadratic time/space, so might be slow.\n");
-        //WspdValidator<T,dimension> wspdValidator;
-        //wspdValidator.ValidateWspd(wssd.GetKWssd<1>(), points);
+        WssdConstructor<T,dimension,2> wssd2Constructor(eta, maxAlpha);
+        //wssd2Constructor.SetMortonOrder(true);
+
+        if(fusedPipeline)
+        {
+            // Construct the filtration straight from the quadtree, the WSSD is never stored
+            printf("Constructing filtration.\n");
+            filtrationConstructor.ConstructFiltration(quadtree, wpsdConstructor, wssd2Constructor, filtration);
+        }
+        else
+        {
+            WSSD<T,dimension> wssd(eta);
+
+            // Create WSPD
+            metrics.BeginStage("wspd");
+            wpsdConstructor.ConstructWspd(quadtree, wssd.GetKWssd<1>());
+            metrics.AddCount("pairs", wssd.GetKWssd<1>().size());
+            metrics.EndStage();
+
+            printf("Number of 1-WSSD pairs: %d\n\n", wssd.GetKWssd<1>().size());
+
+            //// Print stats of the (eta,1)-WSSD
+            //WssdStats<T,dimension,1> wspdStats;
+            //wspdStats.PrintStats(wspdTuples);
+
+            //// Validate the (eta,1)-WSSD
+            //printf("Starting (eta,1)-WSSD validation. Takes quadratic time/space, so might be slow.\n");
+            //WspdValidator<T,dimension> wspdValidator;
+            //wspdValidator.ValidateWspd(wssd.GetKWssd<1>(), points);
+
+            //// Validate the (eta,1)-WSSD on a sample of the pairs. Scales to large point sets.
+            //WspdValidator<T,dimension> sampledWspdValidator;
+            //sampledWspdValidator.ValidateWspdSampled(wssd.GetKWssd<1>(), points, 1000000);
         
 
-        // Construct (eta,2)-WSSD
-        WssdConstructor<T,dimension,2> wssd2Constructor(eta, maxAlpha);
-        wssd2Constructor.ConstructWssd(wssd.GetKWssd<1>(), quadtree, wssd.GetKWssd<2>());
+            // Construct (eta,2)-WSSD
+            metrics.BeginStage("wssd_2");
+            wssd2Constructor.ConstructWssd(wssd.GetKWssd<1>(), quadtree, wssd.GetKWssd<2>());
+            metrics.AddCount("tuples", wssd.GetKWssd<2>().size());
+            metrics.EndStage();
 
-        printf("Number of 2-WSSD tuples: %d\n\n", wssd.GetKWssd<2>().size());
+            printf("Number of 2-WSSD tuples: %d\n\n", wssd.GetKWssd<2>().size());
 
-        //// Print stats of the (eta,2)-WSSD
-        //WssdStats<T,dimension,2> wssdStats;
-        //wssdStats.PrintStats(wssd2Tuples);
+            //// Print stats of the (eta,2)-WSSD
+            //WssdStats<T,dimension,2> wssdStats;
+            //wssdStats.PrintStats(wssd2Tuples);
 
-        //// Validate (eta,2)-WSSD
-        //printf("Starting (eta,2)-WSSD validation. Takes cubic time/space, so might be slow.\n");
-        //WssdValidator<T,dimension,2> wssd2Validator;
-        //wssd2Validator.ValidateWssd(wssd.GetKWssd<2>(), points);
+            //// Validate (eta,2)-WSSD
+            //printf("Starting (eta,2)-WSSD validation. Takes cubic time/space, so might be slow.\n");
+            //WssdValidator<T,dimension,2> wssd2Validator;
+            //wssd2Validator.ValidateWssd(wssd.GetKWssd<2>(), points);
 
-        // Construct the filtration
-        printf("Constructing filtration.\n");
-        Filtration<T,dimension> filtration;
-        FiltrationConstructor<T,dimension> filtrationConstructor(eps, 0, maxDelta);
-        filtrationConstructor.ConstructFiltration(wssd, filtration);
+            //// Validate the (eta,2)-WSSD on a sample of the triples. Scales to large point sets.
+            //WssdValidator<T,dimension,2> sampledWssd2Validator;
+            //sampledWssd2Validator.ValidateWssdSampled(wssd.GetKWssd<2>(), points, 1000000);
+
+            // Construct the filtration
+            printf("Constructing filtration.\n");
+            filtrationConstructor.ConstructFiltration(wssd, filtration);
+        }
 
         // Validate that the filtration has the correct setup
         //FiltrationValidator<T,dimension> filtValidator;
         //filtValidator.ValidateFiltration(filtration);
 
+        //// Compute the persistence pairs
+        //printf("Computing persistence.\n");
+        //PersistenceReducer<T,dimension> persistenceReducer;
+        //std::vector<PersistencePair> persistencePairs;
+        //persistenceReducer.ComputePairs(filtration, persistencePairs);
+        //persistenceReducer.PrintStats(persistencePairs);
+
         printf("Writing to file.\n");
         Exporter<T,dimension> exporter;
 
         char outputFile[120];
         sprintf_s(outputFile, "filtration_%f.txt", eps);  
-        exporter.Export(filtration, outputFile);
+        metrics.BeginStage("export");
+        exporter.ExportFast(filtration, outputFile);
+        metrics.AddCount("simplices", filtration.simplices.size());
+        metrics.EndStage();
+
+        //sprintf_s(outputFile, "filtration_%f.bin", eps);
+        //exporter.ExportBinary(filtration, outputFile);
+
+        //sprintf_s(outputFile, "filtration_%f.phat", eps);
+        //exporter.ExportPhat(filtration, outputFile);
+
+        //sprintf_s(outputFile, "filtration_%f.dipha", eps);
+        //exporter.ExportDipha(filtration, outputFile);
+
+        sprintf_s(outputFile, "metrics_%f.json", eps);
+        metrics.WriteJson(outputFile);
+
+        // Timeline of the stages and threads, open it in chrome://tracing
+        if(traceTimeline)
+        {
+            sprintf_s(outputFile, "trace_%f.json", eps);
+            tracer.WriteChromeTrace(outputFile);
+        }
 
+        // Report the hardware counters of the stages
+        PerfStats perfStats;
+        perfStats.PrintStats(metrics);
+
+        delete quadtree;
+	}
+}
+
+int main(int argc, char** argv)
+{
+    // Raw .bin files don't store their dimension and scalar type, they are read as these
+    const int dimension = 2;
+    typedef double T;
+
+    // Filename, or the first argument
+    //char* fileName = "D:/Downloads/equi_triangle.txt";
+    const char* fileName = (argc > 1 ? argv[1] : "../data/testcase_2_200_0.bin");
+
+    // A point file is run with the instantiation of the dimension and scalar type in its header
+    PointFileHeader header;
+    Pipeline pipeline(fileName, header.Read(std::string(fileName)));
+    if(!pipeline.isPointFile && PointFileHeader::HasMagic(std::string(fileName)))
+    {
+        printf("Point file \"%s\" has a corrupt header.\n", fileName);
         printf("Press enter to continue...\n");
         getchar();
 
-        delete quadtree;
+        return -1;
+    }
+    else if(!pipeline.isPointFile)
+    {
+        pipeline.Run<T,dimension>();
+    }
+    else if(!DispatchInstantiation(header.scalarType, int(header.dimension), pipeline))
+    {
+        printf("Dimension %u is not instantiated, only %d to %d are.\n", header.dimension,
+            kMinInstantiatedDimension, kMaxInstantiatedDimension);
+        printf("Press enter to continue...\n");
+        getchar();
 
-        std::cout << "Leaving program." << std::endl;
+        return -1;
+    }
 
-		// everything's okay
-		return 0;
-	}
+    if(!pipeline.pointsRead)
+    {
+        // couldn't read input file
+        printf("Couldn't read point set \"%s\"\n", fileName);
+    }
 
-    // couldn't read input file
-    printf("Couldn't read point set \"%s\"\n", fileName);
     printf("Press enter to continue...\n");
     getchar();
 
-	return -1;
-}
+    if(!pipeline.pointsRead)
+    {
+        return -1;
+    }
+
+    std::cout << "Leaving program." << std::endl;
+
+	// everything's okay
+	return 0;
+}
\ No newline at end of file